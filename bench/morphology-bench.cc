@@ -0,0 +1,467 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <morphology/Attributes.h>
+#include <morphology/AttributeFilter.h>
+#include <morphology/Reconstruction.h>
+
+using namespace cv;
+using namespace morphology;
+using namespace std;
+
+namespace
+{
+    /**
+     * One timed run of an operation on a workload. The
+     * first five fields identify a run across invocations
+     * of the benchmark.
+     */
+    struct Result
+    {
+        string workload;
+        int size;
+        string operation;
+        string variant;
+        int lambda;
+        double seconds;
+
+        string key() const
+        {
+            ostringstream stream;
+            stream << workload << "," << size << "," << operation << "," << variant << "," << lambda;
+            return stream.str();
+        }
+    };
+
+    struct Options
+    {
+        vector<int> sizes;
+        vector<int> lambdas;
+        vector<string> workloads;
+        vector<string> images;
+        int repetitions;
+        unsigned seed;
+        string format;
+        string output;
+        string baseline;
+        double tolerance;
+
+        Options() : repetitions(3), seed(42), format("csv"), tolerance(0.1)
+        {
+            sizes.push_back(256);
+            sizes.push_back(1024);
+            lambdas.push_back(16);
+            lambdas.push_back(256);
+            const char* all[] = {"noise", "blobs", "gradient", "binary", "flat-zones"};
+            workloads.assign(all, all + 5);
+        }
+    };
+
+    /**
+     * Synthetic workloads. All generators are deterministic for
+     * a given seed, so that results can be compared across runs
+     * and machines.
+     */
+
+    // Uniform noise: many tiny components, deep trees.
+    Mat generateNoise(const int size, RNG& rng)
+    {
+        Mat image(size, size, CV_8U);
+        for (int y = 0; y < size; y++) {
+            uchar* p = image.ptr(y);
+            for (int x = 0; x < size; x++) {
+                p[x] = saturate_cast<uchar>(rng.uniform(0, 256));
+            }
+        }
+        return image;
+    }
+
+    // Overlapping discs of random radius and grey value.
+    Mat generateBlobs(const int size, RNG& rng)
+    {
+        Mat image(size, size, CV_8U, Scalar(0));
+        const int count = std::max(size * size / 2048, 1);
+        for (int i = 0; i < count; i++) {
+            const Point center(rng.uniform(0, size), rng.uniform(0, size));
+            const int radius = rng.uniform(1, std::max(size / 32, 2));
+            circle(image, center, radius, Scalar(rng.uniform(1, 256)), -1);
+        }
+        return image;
+    }
+
+    // Diagonal ramp: few, very large level components.
+    Mat generateGradient(const int size, RNG&)
+    {
+        Mat image(size, size, CV_8U);
+        for (int y = 0; y < size; y++) {
+            uchar* p = image.ptr(y);
+            for (int x = 0; x < size; x++) {
+                p[x] = saturate_cast<uchar>((255.0 * (x + y)) / (2 * size - 2));
+            }
+        }
+        return image;
+    }
+
+    // Binary mask of blobs.
+    Mat generateBinary(const int size, RNG& rng)
+    {
+        const Mat blobs = generateBlobs(size, rng);
+        Mat image(size, size, CV_8U);
+        for (int y = 0; y < size; y++) {
+            const uchar* b = blobs.ptr(y);
+            uchar* p = image.ptr(y);
+            for (int x = 0; x < size; x++) {
+                p[x] = b[x] > 127 ? 255 : 0;
+            }
+        }
+        return image;
+    }
+
+    // Piecewise constant rectangles, as in posterized images.
+    Mat generateFlatZones(const int size, RNG& rng)
+    {
+        Mat image(size, size, CV_8U, Scalar(0));
+        const int count = std::max(size * size / 4096, 1);
+        for (int i = 0; i < count; i++) {
+            const int x = rng.uniform(0, size);
+            const int y = rng.uniform(0, size);
+            const int width = std::min(rng.uniform(1, std::max(size / 16, 2)), size - x);
+            const int height = std::min(rng.uniform(1, std::max(size / 16, 2)), size - y);
+            image(Rect(x, y, width, height)) = Scalar(rng.uniform(0, 8) * 32);
+        }
+        return image;
+    }
+
+    typedef Mat (*Generator)(const int, RNG&);
+
+    Generator findGenerator(const string& name)
+    {
+        if (name == "noise") {
+            return generateNoise;
+        } else if (name == "blobs") {
+            return generateBlobs;
+        } else if (name == "gradient") {
+            return generateGradient;
+        } else if (name == "binary") {
+            return generateBinary;
+        } else if (name == "flat-zones") {
+            return generateFlatZones;
+        }
+        return 0;
+    }
+
+    /**
+     * Returns the median time of running f repetitions times.
+     */
+    template <typename F>
+    double measure(F f, const int repetitions)
+    {
+        vector<double> times;
+        for (int i = 0; i < repetitions; i++) {
+            const int64 start = getTickCount();
+            f();
+            times.push_back((getTickCount() - start) / getTickFrequency());
+        }
+        sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    template <typename A>
+    struct Open
+    {
+        const Mat& src;
+        const int lambda;
+        Open(const Mat& src, const int lambda) : src(src), lambda(lambda) {}
+        void operator()() const
+        {
+            AttributeFilter<A> filter;
+            filter.open(src, lambda);
+        }
+    };
+
+    template <typename A>
+    struct Spectrum
+    {
+        const Mat& src;
+        const int lambda;
+        Spectrum(const Mat& src, const int lambda) : src(src), lambda(lambda) {}
+        void operator()() const
+        {
+            AttributePatternSpectrum<A> spectrum;
+            spectrum.open(src, lambda);
+        }
+    };
+
+    typedef Mat (*ReconstructionFunction)(const Mat&, const Mat&, TaskControl*);
+
+    struct Reconstruct
+    {
+        const Mat& marker;
+        const Mat& mask;
+        const ReconstructionFunction reconstruct;
+        Reconstruct(const Mat& marker, const Mat& mask, ReconstructionFunction reconstruct) :
+            marker(marker), mask(mask), reconstruct(reconstruct)
+        {}
+        void operator()() const
+        {
+            reconstruct(marker, mask, 0);
+        }
+    };
+
+    template <typename A>
+    void benchAttribute(const string& name, const string& workload, const Mat& src,
+                        const Options& options, vector<Result>& results)
+    {
+        for (size_t i = 0; i < options.lambdas.size(); i++) {
+            const int lambda = options.lambdas[i];
+            Result open = {workload, src.cols, "open", name, lambda,
+                           measure(Open<A>(src, lambda), options.repetitions)};
+            results.push_back(open);
+            Result spectrum = {workload, src.cols, "spectrum", name, lambda,
+                               measure(Spectrum<A>(src, lambda), options.repetitions)};
+            results.push_back(spectrum);
+        }
+    }
+
+    void benchReconstruction(const string& workload, const Mat& src,
+                             const Options& options, vector<Result>& results)
+    {
+        const char* names[] = {"parallel", "sequential", "queue", "hybrid"};
+        const ReconstructionFunction functions[] = {parallelReconstruct, sequentialReconstruct,
+                                                    queueReconstruct, hybridReconstruct};
+
+        // The h-domes marker, with lambda as contrast.
+        for (size_t i = 0; i < options.lambdas.size(); i++) {
+            const int h = std::min(options.lambdas[i], 255);
+            const Mat marker = src - h;
+            for (int j = 0; j < 4; j++) {
+                Result result = {workload, src.cols, "reconstruct", names[j], h,
+                                 measure(Reconstruct(marker, src, functions[j]), options.repetitions)};
+                results.push_back(result);
+            }
+        }
+    }
+
+    void bench(const string& workload, const Mat& src, const Options& options, vector<Result>& results)
+    {
+        cerr << "Running " << workload << " at " << src.cols << "x" << src.rows << "..." << endl;
+        benchAttribute<Area>("area", workload, src, options, results);
+        benchAttribute<EqualSideLength>("equal-sides", workload, src, options, results);
+        benchAttribute<FillRatio>("fill-ratio", workload, src, options, results);
+        benchAttribute<Perimeter>("perimeter", workload, src, options, results);
+        benchReconstruction(workload, src, options, results);
+    }
+
+    void writeCsv(ostream& out, const vector<Result>& results)
+    {
+        out << "workload,size,operation,variant,lambda,seconds" << endl;
+        for (size_t i = 0; i < results.size(); i++) {
+            out << results[i].key() << "," << results[i].seconds << endl;
+        }
+    }
+
+    void writeJson(ostream& out, const vector<Result>& results)
+    {
+        out << "[" << endl;
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            out << "  {\"workload\": \"" << r.workload << "\", \"size\": " << r.size
+                << ", \"operation\": \"" << r.operation << "\", \"variant\": \"" << r.variant
+                << "\", \"lambda\": " << r.lambda << ", \"seconds\": " << r.seconds << "}"
+                << (i + 1 < results.size() ? "," : "") << endl;
+        }
+        out << "]" << endl;
+    }
+
+    /**
+     * Reads a baseline written with --format csv, mapping
+     * each key to its time.
+     */
+    bool readBaseline(const string& path, map<string, double>& baseline)
+    {
+        ifstream in(path.c_str());
+        if (!in) {
+            return false;
+        }
+        string line;
+        getline(in, line);
+        while (getline(in, line)) {
+            const size_t comma = line.rfind(',');
+            if (comma != string::npos) {
+                baseline[line.substr(0, comma)] = atof(line.substr(comma + 1).c_str());
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Compares results against the baseline and reports every
+     * run that is slower by more than the tolerance.
+     *
+     * @returns The number of regressions.
+     */
+    int compare(const vector<Result>& results, const map<string, double>& baseline, const double tolerance)
+    {
+        int regressions = 0;
+        for (size_t i = 0; i < results.size(); i++) {
+            const map<string, double>::const_iterator it = baseline.find(results[i].key());
+            if (it == baseline.end() || it->second <= 0) {
+                continue;
+            }
+            const double ratio = results[i].seconds / it->second;
+            if (ratio > 1 + tolerance) {
+                cerr << "Regression: " << results[i].key() << ": " << it->second << "s -> "
+                     << results[i].seconds << "s (" << ratio << "x)" << endl;
+                regressions++;
+            } else if (ratio < 1 - tolerance) {
+                cerr << "Improvement: " << results[i].key() << ": " << it->second << "s -> "
+                     << results[i].seconds << "s (" << ratio << "x)" << endl;
+            }
+        }
+        return regressions;
+    }
+
+    template <typename T>
+    vector<T> parseList(const string& list)
+    {
+        vector<T> values;
+        istringstream stream(list);
+        string item;
+        while (getline(stream, item, ',')) {
+            T value;
+            istringstream(item) >> value;
+            values.push_back(value);
+        }
+        return values;
+    }
+
+    void usage()
+    {
+        cerr << "Usage: morphology-bench [options]\n"
+             << "  --sizes 256,1024         edge lengths of the synthetic images\n"
+             << "  --lambdas 16,256         attribute limits and reconstruction contrasts\n"
+             << "  --workloads noise,...    any of noise, blobs, gradient, binary, flat-zones\n"
+             << "  --image path             add a real image, may be repeated\n"
+             << "  --repetitions 3          runs per measurement, the median is reported\n"
+             << "  --seed 42                seed of the synthetic generators\n"
+             << "  --format csv|json        output format\n"
+             << "  --output path            write results to path instead of stdout\n"
+             << "  --baseline path          compare against a previous csv run\n"
+             << "  --tolerance 0.1          relative slow-down reported as regression\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return EXIT_FAILURE;
+        }
+        const string value = argv[++i];
+        if (arg == "--sizes") {
+            options.sizes = parseList<int>(value);
+        } else if (arg == "--lambdas") {
+            options.lambdas = parseList<int>(value);
+        } else if (arg == "--workloads") {
+            options.workloads = parseList<string>(value);
+        } else if (arg == "--image") {
+            options.images.push_back(value);
+        } else if (arg == "--repetitions") {
+            options.repetitions = std::max(atoi(value.c_str()), 1);
+        } else if (arg == "--seed") {
+            options.seed = atoi(value.c_str());
+        } else if (arg == "--format") {
+            options.format = value;
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--baseline") {
+            options.baseline = value;
+        } else if (arg == "--tolerance") {
+            options.tolerance = atof(value.c_str());
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    vector<Result> results;
+    for (size_t i = 0; i < options.workloads.size(); i++) {
+        const Generator generate = findGenerator(options.workloads[i]);
+        if (!generate) {
+            cerr << "Unknown workload: " << options.workloads[i] << endl;
+            return EXIT_FAILURE;
+        }
+        for (size_t j = 0; j < options.sizes.size(); j++) {
+            RNG rng(options.seed);
+            bench(options.workloads[i], generate(options.sizes[j], rng), options, results);
+        }
+    }
+
+    for (size_t i = 0; i < options.images.size(); i++) {
+        const Mat image = imread(options.images[i], CV_LOAD_IMAGE_GRAYSCALE);
+        if (!image.data) {
+            cerr << "Could not find file \"" << options.images[i] << "\"\n";
+            return EXIT_FAILURE;
+        }
+        bench(options.images[i], image, options, results);
+    }
+
+    ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output.c_str());
+    }
+    ostream& out = options.output.empty() ? cout : file;
+    if (options.format == "json") {
+        writeJson(out, results);
+    } else {
+        writeCsv(out, results);
+    }
+
+    if (!options.baseline.empty()) {
+        map<string, double> baseline;
+        if (!readBaseline(options.baseline, baseline)) {
+            cerr << "Could not find file \"" << options.baseline << "\"\n";
+            return EXIT_FAILURE;
+        }
+        if (compare(results, baseline, options.tolerance) > 0) {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
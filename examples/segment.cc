@@ -38,9 +38,7 @@ Mat segmentNaively(const Mat& img)
 {
 
     const int lambda = ultimateAttribute<Area>(img);
-    AttributeFilter<Area> area_filter;
-    const Mat closing = area_filter.close(img, lambda);
-    return closing - img;
+    return attributeBlackTopHat<Area>(img, lambda);
 }
 
 int main(int argc, char** argv)
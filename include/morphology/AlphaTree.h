@@ -0,0 +1,167 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_ALPHA_TREE_H
+#define __MORPHOLOGY_ALPHA_TREE_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+#include "Attributes.h"
+#include "ConnectedComponent.h"
+#include "TaskControl.h"
+
+namespace morphology
+{
+    /**
+     * The alpha-tree of an image, i.e. the hierarchy of its
+     * quasi-flat zones. The alpha-connected component of a pixel
+     * holds all pixels that can be reached from it by steps
+     * between 4-neighbors whose colours differ by at most alpha,
+     * after
+     *
+     * G. K. Ouzounis & P. Soille (2012): "The Alpha-Tree
+     * Algorithm". JRC Scientific and Policy Report.
+     *
+     * The dissimilarity of two neighbors is the largest absolute
+     * difference of their channels, so colour images are not
+     * reduced to one channel. The edges between neighbors are
+     * sorted by counting sort and united in a single union-find
+     * pass, in time linear in the number of pixels.
+     *
+     * Nodes are addressed by index. The pixels are the first
+     * nodes, in scan-line order, and every node comes before its
+     * parent, so the root is the last node. Only CV_8U images are
+     * supported, with any number of channels.
+     */
+    class MORPHOLOGY_EXPORT AlphaTree
+    {
+    public:
+        AlphaTree(const cv::Mat& img, TaskControl* control = 0);
+
+        /**
+         * @returns the size of the image the tree was built on.
+         */
+        cv::Size size() const { return m_size; }
+
+        /**
+         * @returns the parent of each node. The root is
+         * its own parent.
+         */
+        const std::vector<int>& parent() const { return m_parent; }
+
+        /**
+         * @returns the alpha of each node, i.e. the largest
+         * dissimilarity of the edges within it. Pixels have
+         * an alpha of 0.
+         */
+        const std::vector<uchar>& alphas() const { return m_alphas; }
+
+        /**
+         * @returns the number of pixels of each node.
+         */
+        const std::vector<int>& areas() const { return m_areas; }
+
+        int root() const { return static_cast<int>(m_parent.size()) - 1; }
+
+        /**
+         * @returns the attribute A of each node. Contour attributes
+         * are not supported, as nodes are not built from
+         * neighboring pixels.
+         */
+        template <typename A>
+        std::vector<int> attributes() const
+        {
+            static_assert(!UsesContour<A>::value, "contour attributes are not supported on the alpha-tree");
+
+            const int pixels = m_size.area();
+            std::vector<int> attributes(m_parent.size(), 0);
+            std::vector<ConnectedComponentP_t> nodes(m_parent.size());
+
+            // Children come before their parents.
+            for (int n = 0; n < static_cast<int>(m_parent.size()); n++) {
+                if (n < pixels) {
+                    nodes[n] = ConnectedComponent::create<A>(0, n % m_size.width, n / m_size.width, n);
+                }
+
+                attributes[n] = nodes[n]->m_attribute->compute();
+                const int q = m_parent[n];
+                if (q == n) {
+                    nodes[n]->m_parent.release();
+                } else if (nodes[q].empty()) {
+                    nodes[q] = nodes[n];
+                } else {
+                    nodes[n]->setParent(nodes[q]);
+                }
+                nodes[n].release();
+            }
+            return attributes;
+        }
+
+        /**
+         * Segments the image into its alpha-connected components,
+         * given the attribute of each node. A component whose
+         * attribute is less than lambda joins the largest kept
+         * component of its closest ancestor that contains one.
+         *
+         * @returns a CV_32S image that labels the regions
+         * consecutively from 0.
+         */
+        cv::Mat cut(const int alpha, const std::vector<int>& attributes, const int lambda) const;
+
+        /**
+         * Segments the image into its alpha-connected components
+         * of at least min_area pixels, see above.
+         */
+        cv::Mat cut(const int alpha, const int min_area = 1) const;
+
+    private:
+        cv::Size m_size;
+        std::vector<int> m_parent;
+        std::vector<uchar> m_alphas;
+        std::vector<int> m_areas;
+    };
+
+    /**
+     * Segments img into its alpha-connected components and merges
+     * components whose attribute is less than lambda into their
+     * surroundings, see AlphaTree::cut().
+     */
+    template <typename A>
+    cv::Mat alphaSegmentation(const cv::Mat& img, const int alpha, const int lambda, TaskControl* control = 0)
+    {
+        const AlphaTree tree(img, control);
+        return tree.cut(alpha, tree.attributes<A>(), lambda);
+    }
+
+    template <>
+    inline cv::Mat alphaSegmentation<Area>(const cv::Mat& img, const int alpha, const int lambda, TaskControl* control)
+    {
+        return AlphaTree(img, control).cut(alpha, lambda);
+    }
+}
+
+#endif // __MORPHOLOGY_ALPHA_TREE_H
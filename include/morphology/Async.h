@@ -0,0 +1,123 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_ASYNC_H
+#define __MORPHOLOGY_ASYNC_H
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+#include "AttributeFilter.h"
+#include "Reconstruction.h"
+#include "TaskControl.h"
+#include "ThreadPool.h"
+
+namespace morphology
+{
+    /**
+     * Asynchronous variants of the filters. Each function queues
+     * the operation on a thread pool and returns immediately. The
+     * future holds the result, or rethrows the exception of the
+     * operation on get(), e.g. OperationCancelled.
+     *
+     * Source images are shared, not copied, so they must not be
+     * modified until the future is ready. The same holds for the
+     * lifetime of control.
+     */
+
+    /**
+     * Runs task on pool.
+     */
+    template <typename R>
+    std::future<R> runAsync(const std::function<R()>& task, ThreadPool& pool = ThreadPool::shared())
+    {
+        // Pool tasks must be copyable, packaged tasks are not.
+        const std::shared_ptr<std::packaged_task<R()> > packaged(new std::packaged_task<R()>(task));
+        pool.submit([packaged]() { (*packaged)(); });
+        return packaged->get_future();
+    }
+
+    template <typename A>
+    std::future<cv::Mat> openAsync(const cv::Mat& src, const int lambda, TaskControl* control = 0,
+                                   ThreadPool& pool = ThreadPool::shared())
+    {
+        return runAsync<cv::Mat>([src, lambda, control]() {
+            return AttributeFilter<A>().open(src, lambda, 0, 0, control);
+        }, pool);
+    }
+
+    template <typename A>
+    std::future<cv::Mat> closeAsync(const cv::Mat& src, const int lambda, TaskControl* control = 0,
+                                    ThreadPool& pool = ThreadPool::shared())
+    {
+        return runAsync<cv::Mat>([src, lambda, control]() {
+            return AttributeFilter<A>().close(src, lambda, 0, 0, control);
+        }, pool);
+    }
+
+    /**
+     * Pattern spectra via opening or closing, see
+     * AttributePatternSpectrum.
+     */
+    template <typename A>
+    std::future<std::vector<int> > openSpectrumAsync(const cv::Mat& src, const int lambda, const int max_size = -1,
+                                                     TaskControl* control = 0, ThreadPool& pool = ThreadPool::shared())
+    {
+        return runAsync<std::vector<int> >([src, lambda, max_size, control]() {
+            return AttributePatternSpectrum<A>().open(src, lambda, max_size, 0, control);
+        }, pool);
+    }
+
+    template <typename A>
+    std::future<std::vector<int> > closeSpectrumAsync(const cv::Mat& src, const int lambda, const int max_size = -1,
+                                                      TaskControl* control = 0, ThreadPool& pool = ThreadPool::shared())
+    {
+        return runAsync<std::vector<int> >([src, lambda, max_size, control]() {
+            return AttributePatternSpectrum<A>().close(src, lambda, max_size, 0, control);
+        }, pool);
+    }
+
+    /**
+     * Reconstructions, see Reconstruction.h.
+     */
+    std::future<cv::Mat> MORPHOLOGY_EXPORT parallelReconstructAsync(const cv::Mat& marker, const cv::Mat& mask,
+                                                                    TaskControl* control = 0,
+                                                                    ThreadPool& pool = ThreadPool::shared());
+    std::future<cv::Mat> MORPHOLOGY_EXPORT sequentialReconstructAsync(const cv::Mat& marker, const cv::Mat& mask,
+                                                                      TaskControl* control = 0,
+                                                                      ThreadPool& pool = ThreadPool::shared());
+    std::future<cv::Mat> MORPHOLOGY_EXPORT queueReconstructAsync(const cv::Mat& marker, const cv::Mat& mask,
+                                                                 TaskControl* control = 0,
+                                                                 ThreadPool& pool = ThreadPool::shared());
+    std::future<cv::Mat> MORPHOLOGY_EXPORT hybridReconstructAsync(const cv::Mat& marker, const cv::Mat& mask,
+                                                                  TaskControl* control = 0,
+                                                                  ThreadPool& pool = ThreadPool::shared());
+}
+
+#endif // __MORPHOLOGY_ASYNC_H
@@ -32,7 +32,10 @@
 
 #include "config.h"
 #include "Attributes.h"
+#include "Channels.h"
 #include "ConnectedComponent.h"
+#include "FilterStatistics.h"
+#include "TaskControl.h"
 #include "Utils.h"
 
 namespace morphology
@@ -87,10 +90,70 @@ namespace morphology
             }
             return sets;
         }
+
+        /**
+         * Tells the set of current how many of its 4-neighbors
+         * were processed before it and belong to its set now.
+         * Call after all unions of current.
+         */
+        inline void connectNeighbors(ConnectedComponentP_t& current, const std::vector<ConnectedComponentP_t>& pixels,
+                                     const int rows, const int cols, FilterStatistics* statistics)
+        {
+            const int dx[] = {0, -1, 1, 0};
+            const int dy[] = {-1, 0, 0, 1};
+
+            int neighbors = 0;
+            for (int n = 0; n < 4; n++) {
+                const int x = current->m_x + dx[n];
+                const int y = current->m_y + dy[n];
+                if (x < 0 || x >= cols || y < 0 || y >= rows) {
+                    continue;
+                }
+
+                ConnectedComponentP_t neighbor = pixels[computeIdx(x, y, cols)];
+                if (neighbor < current && ConnectedComponent::findRoot(neighbor, statistics) == current) {
+                    neighbors++;
+                }
+            }
+            current->m_attribute->connect(neighbors);
+        }
     }
 
     /**
-     * An attribute filter for the attribute A.
+     * State of a single call to a filter. Filters keep no state
+     * of their own, so one filter object can be shared by many
+     * threads. Derived filters extend the workspace with their
+     * own per-call state.
+     */
+    struct FilterWorkspace
+    {
+        int lambda;
+        FilterStatistics* statistics;
+        TaskControl* control;
+
+        // Per-pixel lambdas of type CV_32S, or null.
+        const cv::Mat* lambdas;
+
+        FilterWorkspace(const int _lambda, FilterStatistics* _statistics, TaskControl* _control, const cv::Mat* _lambdas = 0) :
+            lambda(_lambda), statistics(_statistics), control(_control), lambdas(_lambdas)
+        {}
+
+        /**
+         * @returns lambda for the set of root. A lambda map is read
+         * at the root pixel, which is the lowest pixel of the set
+         * and the last one that joined it.
+         */
+        int lambdaOf(const ConnectedComponentP_t& root) const
+        {
+            return lambdas ? lambdas->at<int>(root->m_y, root->m_x) : lambda;
+        }
+    };
+
+    /**
+     * An attribute filter for the attribute A. The filter stops
+     * growing a set once its attribute reaches lambda, which is
+     * only correct for increasing attributes. Use TreeFilter for
+     * attributes like EqualSideLength or FillRatio.
      */
     template <typename A>
     class MORPHOLOGY_EXPORT AttributeFilter
@@ -98,37 +161,112 @@ namespace morphology
     public:
         virtual ~AttributeFilter() {}
 
-        void open(cv::Mat& dst, int lambda, std::vector<cv::Ptr<A> >* attributes = 0);
-        cv::Mat open(const cv::Mat& src, int lambda, std::vector<cv::Ptr<A> >* attributes = 0);
+        /**
+         * If statistics is given and the library was built with
+         * MORPHOLOGY_STATISTICS, the counters of this call are
+         * added to it. If control is given, it is checked once
+         * per grey level; cancellation throws OperationCancelled
+         * and leaves dst undefined.
+         *
+         * Multi-channel images are filtered marginally, i.e. each
+         * channel on its own and all channels concurrently, see
+         * processChannels(). For them, attributes must be null and
+         * statistics are not collected. There is no lexicographic
+         * ordering here, as colour ranks do not fit into CV_8U;
+         * use TreeFilter to order colours lexicographically.
+         */
+        void open(cv::Mat& dst, int lambda, std::vector<cv::Ptr<A> >* attributes = 0, FilterStatistics* statistics = 0, TaskControl* control = 0) const;
+        cv::Mat open(const cv::Mat& src, int lambda, std::vector<cv::Ptr<A> >* attributes = 0, FilterStatistics* statistics = 0, TaskControl* control = 0) const;
+
+        void close(cv::Mat &dst, int lambda, std::vector<cv::Ptr<A> >* attributes = 0, FilterStatistics* statistics = 0, TaskControl* control = 0) const;
+        cv::Mat close(const cv::Mat &src, int lambda, std::vector<cv::Ptr<A> >* attributes = 0, FilterStatistics* statistics = 0, TaskControl* control = 0) const;
+
+        /**
+         * Filters with a lambda for each pixel, given as a CV_32S
+         * image of the size of the image to filter. A set grows
+         * as long as its attribute is less than the lambda at its
+         * lowest pixel, so components can be filtered with varying
+         * lambdas in one pass without being cut apart.
+         */
+        void open(cv::Mat& dst, const cv::Mat& lambdas, std::vector<cv::Ptr<A> >* attributes = 0, FilterStatistics* statistics = 0, TaskControl* control = 0) const;
+        cv::Mat open(const cv::Mat& src, const cv::Mat& lambdas, std::vector<cv::Ptr<A> >* attributes = 0, FilterStatistics* statistics = 0, TaskControl* control = 0) const;
 
-        void close(cv::Mat &dst, int lambda, std::vector<cv::Ptr<A> >* attributes = 0);
-        cv::Mat close(const cv::Mat &src, int lambda, std::vector<cv::Ptr<A> >* attributes = 0);
+        void close(cv::Mat &dst, const cv::Mat& lambdas, std::vector<cv::Ptr<A> >* attributes = 0, FilterStatistics* statistics = 0, TaskControl* control = 0) const;
+        cv::Mat close(const cv::Mat &src, const cv::Mat& lambdas, std::vector<cv::Ptr<A> >* attributes = 0, FilterStatistics* statistics = 0, TaskControl* control = 0) const;
 
     protected:
-        int m_lambda;
+        /**
+         * Performs an opening of dst in-place.
+         */
+        void filter(cv::Mat& dst, FilterWorkspace& workspace, std::vector<cv::Ptr<A> >* attributes) const;
 
         /**
          * Unites the pixel sets according to activity.
          */
-        std::vector<ConnectedComponentP_t> buildSets(const std::vector<ConnectedComponentP_t>& pixels, const int rows, const int cols);
+        std::vector<ConnectedComponentP_t> buildSets(const std::vector<ConnectedComponentP_t>& pixels, const int rows, const int cols,
+                                                     FilterWorkspace& workspace) const;
 
         /**
          * Unites two pixels and their corresponding
          * sets.
          */
-        virtual void unite(ConnectedComponentP_t& neighbor, ConnectedComponentP_t& current);
+        virtual void unite(ConnectedComponentP_t& neighbor, ConnectedComponentP_t& current, FilterWorkspace& workspace) const;
 
+        /**
+         * @returns true if the set of root may still grow.
+         */
+        virtual bool isActive(ConnectedComponentP_t& root, FilterWorkspace& workspace) const
+        {
+            return root->isActive(workspace.lambdaOf(root), workspace.statistics);
+        }
     };
 
     template <typename A>
-    void AttributeFilter<A>::open(cv::Mat& dst, int lambda, std::vector<cv::Ptr<A> >* attributes)
+    void AttributeFilter<A>::open(cv::Mat& dst, int lambda, std::vector<cv::Ptr<A> >* attributes, FilterStatistics* statistics, TaskControl* control) const
     {
-        CV_Assert(dst.type() == CV_8U);
+        CV_Assert(dst.depth() == CV_8U);
+        if (dst.channels() > 1) {
+            CV_Assert(!attributes);
+            processChannels(dst, [&](const cv::Mat& channel) {
+                return open(channel, lambda, 0, 0, control);
+            }).copyTo(dst);
+            return;
+        }
 
-        m_lambda = lambda;
+        FilterWorkspace workspace(lambda, statistics, control);
+        filter(dst, workspace, attributes);
+    }
 
+    template <typename A>
+    void AttributeFilter<A>::open(cv::Mat& dst, const cv::Mat& lambdas, std::vector<cv::Ptr<A> >* attributes, FilterStatistics* statistics, TaskControl* control) const
+    {
+        CV_Assert(dst.depth() == CV_8U);
+        CV_Assert(lambdas.type() == CV_32S && lambdas.size() == dst.size());
+        if (dst.channels() > 1) {
+            CV_Assert(!attributes);
+            processChannels(dst, [&](const cv::Mat& channel) {
+                return open(channel, lambdas, 0, 0, control);
+            }).copyTo(dst);
+            return;
+        }
+
+        FilterWorkspace workspace(0, statistics, control, &lambdas);
+        filter(dst, workspace, attributes);
+    }
+
+    template <typename A>
+    void AttributeFilter<A>::filter(cv::Mat& dst, FilterWorkspace& workspace, std::vector<cv::Ptr<A> >* attributes) const
+    {
+        FilterStatistics* statistics = workspace.statistics;
         const std::vector<ConnectedComponentP_t> sets = makePixelSets<A>(dst);
-        std::vector<ConnectedComponentP_t> sorted = buildSets(sets, dst.rows, dst.cols);
+
+        // Every pixel owns a set, an attribute, their two
+        // reference counters and is referenced from the
+        // pixel and the sorted vectors.
+        MORPHOLOGY_COUNT(statistics, peak_node_memory = std::max(statistics->peak_node_memory,
+            sets.size() * (sizeof(ConnectedComponent) + sizeof(A) + 2 * sizeof(int) + 2 * sizeof(ConnectedComponentP_t))));
+
+        std::vector<ConnectedComponentP_t> sorted = buildSets(sets, dst.rows, dst.cols, workspace);
 
         // Resolve pixel sets by assigning the grey value
         // of each root to the members of its set.
@@ -143,40 +281,77 @@ namespace morphology
     }
 
     template <typename A>
-    cv::Mat AttributeFilter<A>::open(const cv::Mat& src, int lambda, std::vector<cv::Ptr<A> >* attributes)
+    cv::Mat AttributeFilter<A>::open(const cv::Mat& src, int lambda, std::vector<cv::Ptr<A> >* attributes, FilterStatistics* statistics, TaskControl* control) const
     {
         cv::Mat dst = src.clone();
-        open(dst, lambda, attributes);
+        open(dst, lambda, attributes, statistics, control);
         return dst;
     }
 
     template <typename A>
-    void  AttributeFilter<A>::close(cv::Mat& dst, int lambda, std::vector<cv::Ptr<A> >* attributes)
+    void  AttributeFilter<A>::close(cv::Mat& dst, int lambda, std::vector<cv::Ptr<A> >* attributes, FilterStatistics* statistics, TaskControl* control) const
     {
-        CV_Assert(dst.type() == CV_8U);
+        CV_Assert(dst.depth() == CV_8U);
         negative(dst);
-        open(dst, lambda, attributes);
+        open(dst, lambda, attributes, statistics, control);
         negative(dst);
     }
 
     template <typename A>
-    cv::Mat AttributeFilter<A>::close(const cv::Mat& src, int lambda, std::vector<cv::Ptr<A> >* attributes)
+    cv::Mat AttributeFilter<A>::close(const cv::Mat& src, int lambda, std::vector<cv::Ptr<A> >* attributes, FilterStatistics* statistics, TaskControl* control) const
     {
         cv::Mat dst = src.clone();
-        close(dst, lambda, attributes);
+        close(dst, lambda, attributes, statistics, control);
         return dst;
     }
 
     template <typename A>
-    std::vector<ConnectedComponentP_t> AttributeFilter<A>::buildSets(const std::vector<ConnectedComponentP_t>& pixels, const int rows, const int cols)
+    cv::Mat AttributeFilter<A>::open(const cv::Mat& src, const cv::Mat& lambdas, std::vector<cv::Ptr<A> >* attributes, FilterStatistics* statistics, TaskControl* control) const
+    {
+        cv::Mat dst = src.clone();
+        open(dst, lambdas, attributes, statistics, control);
+        return dst;
+    }
+
+    template <typename A>
+    void AttributeFilter<A>::close(cv::Mat& dst, const cv::Mat& lambdas, std::vector<cv::Ptr<A> >* attributes, FilterStatistics* statistics, TaskControl* control) const
+    {
+        CV_Assert(dst.depth() == CV_8U);
+        negative(dst);
+        open(dst, lambdas, attributes, statistics, control);
+        negative(dst);
+    }
+
+    template <typename A>
+    cv::Mat AttributeFilter<A>::close(const cv::Mat& src, const cv::Mat& lambdas, std::vector<cv::Ptr<A> >* attributes, FilterStatistics* statistics, TaskControl* control) const
+    {
+        cv::Mat dst = src.clone();
+        close(dst, lambdas, attributes, statistics, control);
+        return dst;
+    }
+
+    template <typename A>
+    std::vector<ConnectedComponentP_t> AttributeFilter<A>::buildSets(const std::vector<ConnectedComponentP_t>& pixels, const int rows, const int cols,
+                                                                     FilterWorkspace& workspace) const
     {
         std::vector<ConnectedComponentP_t> sorted = pixels;
+#ifdef MORPHOLOGY_STATISTICS
+        const int64 start = cv::getTickCount();
+#endif
         sort(sorted.begin(), sorted.end(), std::less<ConnectedComponentP_t>());
+#ifdef MORPHOLOGY_STATISTICS
+        MORPHOLOGY_COUNT(workspace.statistics, sort_time += (cv::getTickCount() - start) / cv::getTickFrequency());
+#endif
 
         // Build disjoint pixel sets
         for (std::vector<ConnectedComponentP_t>::iterator it = sorted.begin(); it != sorted.end(); it++) {
             ConnectedComponentP_t current = *it;
 
+            // Check for cancellation once per grey level.
+            if (workspace.control && (it == sorted.begin() || *current->m_pixel != *(*(it - 1))->m_pixel)) {
+                workspace.control->checkpoint(static_cast<double>(it - sorted.begin()) / sorted.size());
+            }
+
             // Compute pixel coordinate limits.
             const int x_lower = std::max(current->m_x - 1, 0);
             const int x_upper = std::min(current->m_x + 1, cols - 1);
@@ -192,18 +367,25 @@ namespace morphology
                     // than current or if they are at level and neighbor
                     // comes before current in scan-line order.
                     if (*current->m_pixel < *neighbor->m_pixel || neighbor < current) {
-                        unite(neighbor, current);
+                        unite(neighbor, current, workspace);
                     }
                 }
             }
+
+            // Contour attributes count the edges
+            // that current closes within its set.
+            if (UsesContour<A>::value) {
+                connectNeighbors(current, pixels, rows, cols, workspace.statistics);
+            }
         }
         return sorted;
     }
 
     template <typename A>
-    void AttributeFilter<A>::unite(ConnectedComponentP_t& neighbor, ConnectedComponentP_t& current)
+    void AttributeFilter<A>::unite(ConnectedComponentP_t& neighbor, ConnectedComponentP_t& current, FilterWorkspace& workspace) const
     {
-        ConnectedComponentP_t root = ConnectedComponent::findRoot(neighbor);
+        FilterStatistics* statistics = workspace.statistics;
+        ConnectedComponentP_t root = ConnectedComponent::findRoot(neighbor, statistics);
 
         // If root and current are the same,
         // neighbor and current are already
@@ -213,9 +395,17 @@ namespace morphology
             // Unite sets if root and current are level
             // pixels or if root's attribute is still
             // active for lambda.
-            if (*root->m_pixel == *current->m_pixel || root->isActive(m_lambda)) {
+            if (*root->m_pixel == *current->m_pixel) {
+                // A set at level that turned inactive
+                // deactivates the set it joins.
+                MORPHOLOGY_COUNT(statistics, unions++);
+                current->m_active = current->m_active && root->m_active;
+                root->setParent(current);
+            } else if (isActive(root, workspace)) {
+                MORPHOLOGY_COUNT(statistics, unions++);
                 root->setParent(current);
             } else {
+                MORPHOLOGY_COUNT(statistics, rejected_merges++);
                 current->m_active = false;
             }
         }
@@ -234,7 +424,7 @@ namespace morphology
          * @param max_size The maximum size of the element to filter, defaults to 20% of the image area.
          * @return Differential pattern spectrum of the image for given attribute.
          */
-        std::vector<int> open(const cv::Mat& src, int lambda, int max_size = -1);
+        std::vector<int> open(const cv::Mat& src, int lambda, int max_size = -1, FilterStatistics* statistics = 0, TaskControl* control = 0) const;
 
         /**
          * @brief close Computes a pattern spectrum via closing.
@@ -243,60 +433,63 @@ namespace morphology
          * @param max_size The maximum size of the element to filter, defaults to 20% of the image area.
          * @return Differential pattern spectrum of the image for given attribute.
          */
-        std::vector<int> close(const cv::Mat& src, int lambda, int max_size = -1);
+        std::vector<int> close(const cv::Mat& src, int lambda, int max_size = -1, FilterStatistics* statistics = 0, TaskControl* control = 0) const;
 
     private:
-        std::vector<int> m_spectrum;
-        int m_lambda;
-        int m_max_size;
+        struct Workspace : public FilterWorkspace
+        {
+            std::vector<int> spectrum;
+            int max_size;
 
-        virtual void unite(ConnectedComponentP_t& neighbor, ConnectedComponentP_t& current);
+            Workspace(const int lambda, const int _max_size, FilterStatistics* statistics, TaskControl* control) :
+                FilterWorkspace(lambda, statistics, control), spectrum(lambda), max_size(_max_size)
+            {}
+        };
+
+        virtual void unite(ConnectedComponentP_t& neighbor, ConnectedComponentP_t& current, FilterWorkspace& workspace) const;
     };
 
     template <typename A>
-    std::vector<int> AttributePatternSpectrum<A>::open(const cv::Mat& src, int lambda, int max_size)
+    std::vector<int> AttributePatternSpectrum<A>::open(const cv::Mat& src, int lambda, int max_size, FilterStatistics* statistics, TaskControl* control) const
     {
         CV_Assert(src.type() == CV_8U);
 
         if (max_size < 0) {
-            m_max_size = (src.cols * src.rows) / 5;
-        } else {
-            m_max_size = max_size;
+            max_size = (src.cols * src.rows) / 5;
         }
-
-        m_lambda = lambda;
-        m_spectrum.clear();
-        m_spectrum.resize(m_lambda);
+        Workspace workspace(lambda, max_size, statistics, control);
 
         // For the sake of code re-use, we
         // perform an actual opening.
         cv::Mat aux = src.clone();
         const std::vector<ConnectedComponentP_t> sets = makePixelSets<A>(aux);
-        AttributeFilter<A>::buildSets(sets, aux.rows, aux.cols);
+        AttributeFilter<A>::buildSets(sets, aux.rows, aux.cols, workspace);
 
-        return m_spectrum;
+        return workspace.spectrum;
     }
 
     template <typename A>
-    std::vector<int> AttributePatternSpectrum<A>::close(const cv::Mat& src, int lambda, int max_size)
+    std::vector<int> AttributePatternSpectrum<A>::close(const cv::Mat& src, int lambda, int max_size, FilterStatistics* statistics, TaskControl* control) const
     {
         CV_Assert(src.type() == CV_8U);
-        return open(negative(src), lambda, max_size);
+        return open(negative(src), lambda, max_size, statistics, control);
     }
 
     template <typename A>
-    void AttributePatternSpectrum<A>::unite(ConnectedComponentP_t& neighbor, ConnectedComponentP_t& current)
+    void AttributePatternSpectrum<A>::unite(ConnectedComponentP_t& neighbor, ConnectedComponentP_t& current, FilterWorkspace& workspace) const
     {
-        ConnectedComponentP_t root = ConnectedComponent::findRoot(neighbor);
+        Workspace& w = static_cast<Workspace&>(workspace);
+        ConnectedComponentP_t root = ConnectedComponent::findRoot(neighbor, w.statistics);
 
-        CV_Assert(current == current->m_parent);
+        CV_DbgAssert(current == current->m_parent);
 
-        if (root != current && root->m_size <= m_max_size) {
+        if (root != current && root->m_size <= w.max_size) {
 
             // Set spectrum grey value
-            if (*root->m_pixel == *current->m_pixel || root->isActive(m_lambda)) {
-                m_spectrum[root->m_attribute->compute()] += (*root->m_pixel - *current->m_pixel) * root->m_size;
+            if (*root->m_pixel == *current->m_pixel || root->isActive(w.lambda, w.statistics)) {
+                w.spectrum[root->m_attribute->compute()] += (*root->m_pixel - *current->m_pixel) * root->m_size;
             }
+            MORPHOLOGY_COUNT(w.statistics, unions++);
             root->setParent(current);
         }
     }
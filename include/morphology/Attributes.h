@@ -25,7 +25,7 @@
 #ifndef __MORPHOLOGY_ATTRIBUTE_H
 #define __MORPHOLOGY_ATTRIBUTE_H
 
-#include <map>
+#include <type_traits>
 #include <vector>
 
 #include <opencv2/core/core.hpp>
@@ -50,10 +50,28 @@ namespace morphology
          */
         virtual int compute() = 0;
 
+        /**
+         * @returns true if compute() < lambda. Filters only need
+         * this decision, so attributes override it to compare
+         * integer accumulators against lambda without divisions.
+         * Attributes derived from an attribute that overrides
+         * lessThan() must override it, too.
+         */
+        virtual bool lessThan(const int lambda) { return compute() < lambda; }
+
         /**
          * Unites another attribute with this one in-place.
          */
         virtual void merge(const cv::Ptr<Attribute>& other) = 0;
+
+        /**
+         * Called once a pixel is processed, with the number of
+         * its 4-neighbors that were processed before it and now
+         * belong to the same set. Only attributes derived from
+         * ContourAttribute are notified, so that other filters
+         * do not pay for it.
+         */
+        virtual void connect(const int /* neighbors */) {}
     };
 
     /**
@@ -69,6 +87,7 @@ namespace morphology
          * Returns the area of this set.
          */
         virtual int compute();
+        virtual bool lessThan(const int lambda);
         virtual void merge(const cv::Ptr<Attribute>& other);
 
     protected:
@@ -89,10 +108,10 @@ namespace morphology
         // These members describe the limits
         // of the bounding box enclosing
         // the connected set.
-        double x_min;
-        double x_max;
-        double y_min;
-        double y_max;
+        int x_min;
+        int x_max;
+        int y_min;
+        int y_max;
     };
 
     /**
@@ -109,6 +128,7 @@ namespace morphology
          * between 0 an 100.
          */
         virtual int compute();
+        virtual bool lessThan(const int lambda);
     };
 
     /**
@@ -125,35 +145,186 @@ namespace morphology
          * bounding box the sets area in [0, 100].
          */
         virtual int compute();
+        virtual bool lessThan(const int lambda);
         virtual void merge(const cv::Ptr<Attribute>& other);
     };
 
+    /**
+     * Abstract base class for attributes using the perimeter
+     * of a connected set, i.e. the number of pixel edges between
+     * the set and its complement. The perimeter is maintained
+     * incrementally: a pixel contributes its four edges, and each
+     * pair of 4-adjacent pixels in the same set removes two. So
+     * merging two sets costs O(1).
+     */
     class MORPHOLOGY_EXPORT ContourAttribute : virtual public Attribute
     {
     public:
         ContourAttribute(const ConnectedComponentP_t& pixel);
         virtual void merge(const cv::Ptr<Attribute>& other);
+        virtual void connect(const int neighbors);
+
+    protected:
+        int m_perimeter;
+    };
+
+    /**
+     * Tells filters whether the attribute A needs to be notified
+     * by connect(). Specialize it for attributes that contain
+     * contour attributes without deriving from them.
+     */
+    template <typename A>
+    struct UsesContour : std::is_base_of<ContourAttribute, A> {};
+
+    /**
+     * Represents the perimeter of a connected set.
+     */
+    class MORPHOLOGY_EXPORT Perimeter : virtual public ContourAttribute
+    {
+    public:
+        Perimeter(const ConnectedComponentP_t& pixel);
+
+        /**
+         * Returns the number of edges of the set.
+         */
+        virtual int compute();
+        virtual bool lessThan(const int lambda);
+    };
+
+    /**
+     * Represents the compactness of a connected set.
+     */
+    class MORPHOLOGY_EXPORT Compactness : virtual public ContourAttribute, virtual public Area
+    {
+    public:
+        Compactness(const ConnectedComponentP_t& pixel);
+
+        /**
+         * Returns the squared perimeter over the area, which
+         * is 16 for squares and grows with the elongation and
+         * raggedness of the set.
+         */
+        virtual int compute();
+        virtual bool lessThan(const int lambda);
+        virtual void merge(const cv::Ptr<Attribute>& other);
+    };
+
+    /**
+     * Represents the circularity of a connected set.
+     */
+    class MORPHOLOGY_EXPORT Circularity : virtual public ContourAttribute, virtual public Area
+    {
+    public:
+        Circularity(const ConnectedComponentP_t& pixel);
+
+        /**
+         * Returns 4 pi A / P^2 in [0, 100], which is
+         * about 78 for squares and small for thin or
+         * ragged sets.
+         */
+        virtual int compute();
+        virtual bool lessThan(const int lambda);
+        virtual void merge(const cv::Ptr<Attribute>& other);
+    };
+
+    /**
+     * Abstract base class for attributes using the first and
+     * second order moments of a connected set. The raw moments
+     * are integer sums over the pixel coordinates, so merging
+     * two sets costs O(1). Derived attributes evaluate the
+     * central moments only when compute() is called.
+     */
+    class MORPHOLOGY_EXPORT MomentAttribute : virtual public Attribute
+    {
+    public:
+        MomentAttribute(const ConnectedComponentP_t& pixel);
+        virtual void merge(const cv::Ptr<Attribute>& other);
 
     protected:
+        int m00;
+        long long m10;
+        long long m01;
+        long long m20;
+        long long m02;
+        long long m11;
+
         /**
-        * Maps a point to an integer after
-        * the Cantor Pairing Function.
-        */
-        struct HashedPoint
-        {
-            int hash;
-            cv::Ptr<const cv::Point> point;
+         * Computes the central second order moments, treating
+         * each pixel as a unit square, so that even single
+         * pixels have a non-degenerate shape.
+         */
+        void computeCentralMoments(double& mu20, double& mu02, double& mu11) const;
+
+        /**
+         * Computes the eigenvalues of the covariance matrix,
+         * i.e. the squared lengths of the main axes of the
+         * ellipse with the same moments, up to a factor.
+         */
+        void computeAxes(double& major, double& minor) const;
+    };
+
+    /**
+     * Represents the elongation of a connected set.
+     */
+    class MORPHOLOGY_EXPORT Elongation : virtual public MomentAttribute
+    {
+    public:
+        Elongation(const ConnectedComponentP_t& pixel);
 
-            HashedPoint();
-        };
+        /**
+         * Returns one minus the ratio of the minor to the major
+         * axis in [0, 100]; 0 for discs and squares, close to
+         * 100 for lines.
+         */
+        virtual int compute();
+    };
 
-        HashedPoint* m_start;
-        std::vector<HashedPoint*> m_contour;
+    /**
+     * Represents the scale-invariant moment of inertia of a
+     * connected set, i.e. (mu20 + mu02) / A^2.
+     */
+    class MORPHOLOGY_EXPORT MomentOfInertia : virtual public MomentAttribute
+    {
+    public:
+        MomentOfInertia(const ConnectedComponentP_t& pixel);
 
-    private:
-        void updateMap();
-        static HashedPoint* getPoint(const int x, const int y);
-        std::map<int, int> m_contour_map;
+        /**
+         * Returns the moment of inertia relative to that of a
+         * disc, times 100. Discs have the minimum of 100, and
+         * the value grows with elongation and raggedness.
+         */
+        virtual int compute();
+    };
+
+    /**
+     * Represents the orientation of a connected set.
+     */
+    class MORPHOLOGY_EXPORT Orientation : virtual public MomentAttribute
+    {
+    public:
+        Orientation(const ConnectedComponentP_t& pixel);
+
+        /**
+         * Returns the angle of the major axis to the x-axis in
+         * degrees in [0, 180), measured clockwise as y grows
+         * downwards.
+         */
+        virtual int compute();
+    };
+
+    /**
+     * Represents the eccentricity of a connected set.
+     */
+    class MORPHOLOGY_EXPORT Eccentricity : virtual public MomentAttribute
+    {
+    public:
+        Eccentricity(const ConnectedComponentP_t& pixel);
+
+        /**
+         * Returns the eccentricity of the ellipse with the
+         * same moments in [0, 100]; 0 for discs.
+         */
+        virtual int compute();
     };
 }
 
@@ -0,0 +1,154 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_BATCH_H
+#define __MORPHOLOGY_BATCH_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+#include "AttributeFilter.h"
+#include "ThreadPool.h"
+
+namespace morphology
+{
+    /**
+     * An operation applied to every image of a batch. The
+     * operation is shared by all workers, so apply() must be
+     * safe to call concurrently.
+     */
+    class MORPHOLOGY_EXPORT ImageOperation
+    {
+    public:
+        virtual ~ImageOperation() {}
+
+        /**
+         * Filters image in-place.
+         */
+        virtual void apply(cv::Mat& image) const = 0;
+    };
+
+    /**
+     * Attribute opening for the attribute A.
+     */
+    template <typename A>
+    class MORPHOLOGY_EXPORT AttributeOpening : public ImageOperation
+    {
+    public:
+        AttributeOpening(const int lambda) : m_lambda(lambda) {}
+
+        virtual void apply(cv::Mat& image) const
+        {
+            m_filter.open(image, m_lambda);
+        }
+
+    private:
+        const AttributeFilter<A> m_filter;
+        const int m_lambda;
+    };
+
+    /**
+     * Attribute closing for the attribute A.
+     */
+    template <typename A>
+    class MORPHOLOGY_EXPORT AttributeClosing : public ImageOperation
+    {
+    public:
+        AttributeClosing(const int lambda) : m_lambda(lambda) {}
+
+        virtual void apply(cv::Mat& image) const
+        {
+            m_filter.close(image, m_lambda);
+        }
+
+    private:
+        const AttributeFilter<A> m_filter;
+        const int m_lambda;
+    };
+
+    /**
+     * Receives the index of an image in its batch and the
+     * filtered image. Callbacks run on the calling thread. The
+     * buffer of the image is reused for later images of the
+     * batch once the callback returns, so clone it to keep it.
+     */
+    typedef std::function<void(const size_t, const cv::Mat&)> BatchCallback;
+
+    enum BatchOrder
+    {
+        // Results are passed on in the order of the batch.
+        BATCH_IN_ORDER,
+
+        // Results are passed on as soon as they are done.
+        BATCH_AS_COMPLETED
+    };
+
+    /**
+     * Batch processing spreads the images of a batch over the
+     * workers of a thread pool. Each image is filtered by a single
+     * worker, so throughput scales with the number of workers. At
+     * most two images per worker are in flight at any time, which
+     * bounds memory use for large batches.
+     *
+     * If an operation throws, no further images are started and
+     * the first exception is rethrown once running images are
+     * done. The functions block until the batch is done and must
+     * not be called from a task of the same pool.
+     */
+
+    /**
+     * @returns the filtered images in the order of the batch.
+     */
+    std::vector<cv::Mat> MORPHOLOGY_EXPORT processBatch(const std::vector<cv::Mat>& images,
+                                                        const ImageOperation& operation,
+                                                        ThreadPool& pool = ThreadPool::shared());
+
+    /**
+     * Passes each filtered image to callback.
+     */
+    void MORPHOLOGY_EXPORT processBatch(const std::vector<cv::Mat>& images,
+                                        const ImageOperation& operation,
+                                        const BatchCallback& callback,
+                                        const BatchOrder order = BATCH_IN_ORDER,
+                                        ThreadPool& pool = ThreadPool::shared());
+
+    /**
+     * Reads every input as a grey-scale image, filters it and
+     * writes it to the output path of the same index. Decoding,
+     * filtering and encoding all happen on the workers, so that
+     * I/O of some images overlaps with filtering of others.
+     *
+     * @returns for each image, whether it was read and written.
+     */
+    std::vector<bool> MORPHOLOGY_EXPORT processFiles(const std::vector<std::string>& inputs,
+                                                     const std::vector<std::string>& outputs,
+                                                     const ImageOperation& operation,
+                                                     ThreadPool& pool = ThreadPool::shared());
+}
+
+#endif // __MORPHOLOGY_BATCH_H
@@ -0,0 +1,96 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_CHANNELS_H
+#define __MORPHOLOGY_CHANNELS_H
+
+#include <functional>
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+
+namespace morphology
+{
+    /**
+     * Decides how filters order the pixels of multi-channel
+     * images, which have no natural order.
+     */
+    enum ChannelOrdering
+    {
+        // Filter each channel on its own. Fast, but the filtered
+        // image may contain colours that are not in the input.
+        ORDER_MARGINAL,
+        // Order colours lexicographically, the first channel
+        // being the most significant. Filters only assign colours
+        // of the input image, but are biased to the first channel.
+        // Only TreeFilter supports this ordering.
+        ORDER_LEXICOGRAPHIC
+    };
+
+    /**
+     * An operation on a single channel that returns the
+     * processed channel.
+     */
+    typedef std::function<cv::Mat(const cv::Mat&)> ChannelOperation;
+
+    /**
+     * An operation on corresponding channels of two images,
+     * like a marker and a mask.
+     */
+    typedef std::function<cv::Mat(const cv::Mat&, const cv::Mat&)> ChannelPairOperation;
+
+    /**
+     * Applies operation to each channel of src and merges the
+     * results. The channels are processed concurrently, one per
+     * thread, so operation must be safe to call concurrently. If
+     * operation throws for any channel, the first exception is
+     * rethrown once all channels are done.
+     */
+    cv::Mat MORPHOLOGY_EXPORT processChannels(const cv::Mat& src, const ChannelOperation& operation);
+
+    /**
+     * Applies operation to each pair of channels of a and b,
+     * which must have the same number of channels, see above.
+     */
+    cv::Mat MORPHOLOGY_EXPORT processChannels(const cv::Mat& a, const cv::Mat& b, const ChannelPairOperation& operation);
+
+    /**
+     * Maps the colours of src, of depth CV_8U with at most four
+     * channels, to their ranks in the lexicographic order. The
+     * ranks are returned as a CV_32F image, so that they can be
+     * filtered like a grey-scale image. palette receives the
+     * distinct colours of src in increasing order as a single
+     * row of the type of src.
+     */
+    cv::Mat MORPHOLOGY_EXPORT lexicographicRanks(const cv::Mat& src, cv::Mat& palette);
+
+    /**
+     * Maps the ranks of an image back to their colours in
+     * palette, see lexicographicRanks().
+     */
+    cv::Mat MORPHOLOGY_EXPORT fromLexicographicRanks(const cv::Mat& ranks, const cv::Mat& palette);
+}
+
+#endif // __MORPHOLOGY_CHANNELS_H
@@ -0,0 +1,411 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_COMPONENT_TREE_H
+#define __MORPHOLOGY_COMPONENT_TREE_H
+
+#include <limits>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+#include "Attributes.h"
+#include "Channels.h"
+#include "ConnectedComponent.h"
+#include "MaxTree.h"
+#include "TaskControl.h"
+
+namespace morphology
+{
+    /**
+     * Decides which nodes of a component tree a filter keeps,
+     * given which nodes satisfy attribute >= lambda. The rules
+     * only differ for non-increasing attributes, after
+     *
+     * P. Salembier, A. Oliveras & L. Garrido (1998): "Antiextensive
+     * Connected Operators for Image and Sequence Processing". In
+     * IEEE Transactions on Image Processing, 7(4):555-570.
+     *
+     * E. R. Urbach, J. B. T. M. Roerdink & M. H. F. Wilkinson
+     * (2007): "Connected Shape-Size Pattern Spectra for Rotation
+     * and Scale-Invariant Classification of Gray-Scale Images".
+     * In IEEE Transactions on Pattern Analysis and Machine
+     * Intelligence, 29(2):272-285.
+     */
+    enum TreeRule
+    {
+        // Keep a node if it and all of its ancestors satisfy
+        // the criterion.
+        RULE_MIN,
+        // Keep a node if it or one of its descendants satisfies
+        // the criterion.
+        RULE_MAX,
+        // Keep a node if it satisfies the criterion. Removed
+        // nodes take the level of their closest kept ancestor.
+        RULE_DIRECT,
+        // Like RULE_DIRECT, but the descendants of removed nodes
+        // are lowered by the contrast of the removed node.
+        RULE_SUBTRACTIVE,
+        // Remove subtrees such that the number of pixels in nodes
+        // that violate their criterion is minimal.
+        RULE_VITERBI
+    };
+
+    enum TreeType
+    {
+        // Tree of the upper level sets, used by openings.
+        MAX_TREE,
+        // Tree of the lower level sets, used by closings.
+        MIN_TREE
+    };
+
+    /**
+     * A max-tree or min-tree with the attribute of each of its
+     * nodes. Other than AttributeFilter, which stops growing a
+     * set once it fails the criterion, the tree knows the value
+     * of every node, so it filters correctly for attributes that
+     * are not increasing, like EqualSideLength or FillRatio.
+     * The tree is built once and can be filtered for any lambda
+     * and rule in time linear in the number of pixels.
+     */
+    class MORPHOLOGY_EXPORT ComponentTree
+    {
+    public:
+        /**
+         * Builds the tree of img and computes attribute A for
+         * each of its nodes.
+         */
+        template <typename A>
+        static ComponentTree build(const cv::Mat& img, const TreeType type = MAX_TREE, TaskControl* control = 0)
+        {
+            return build<A>(img, type, [](Attribute& attribute) { return attribute.compute(); }, control);
+        }
+
+        /**
+         * Builds the tree of img and stores value(attribute) for
+         * each node instead of the attribute, e.g. to filter by a
+         * predicate on several attributes.
+         */
+        template <typename A, typename F>
+        static ComponentTree build(const cv::Mat& img, const TreeType type, const F& value, TaskControl* control = 0)
+        {
+            ComponentTree tree(img, type);
+            tree.m_attributes = computeAttributes<A>(tree.m_tree, value, control);
+            return tree;
+        }
+
+        const MaxTree& tree() const { return m_tree; }
+
+        TreeType type() const { return m_type; }
+
+        /**
+         * @returns the attribute of the node of pixel p.
+         */
+        int attribute(const int p) const { return m_attributes[node(p)]; }
+
+        /**
+         * @returns the canonical pixel of the node of pixel p.
+         */
+        int node(const int p) const { return m_tree.isCanonical(p) ? p : m_tree.parent()[p]; }
+
+        /**
+         * Removes the nodes whose attribute is less than lambda
+         * according to rule. On a min-tree, this is a closing.
+         * @returns an image of the type of the input image.
+         */
+        cv::Mat filter(const int lambda, const TreeRule rule = RULE_DIRECT) const;
+
+        /**
+         * @returns the difference between the image and its filtered
+         * image, i.e. the attribute top-hat on a max-tree and the
+         * black top-hat on a min-tree.
+         */
+        cv::Mat residual(const int lambda, const TreeRule rule = RULE_DIRECT) const;
+
+        /**
+         * @returns the difference between the filtered images for
+         * lambda_low and lambda_high, i.e. the components with an
+         * attribute in [lambda_low, lambda_high).
+         */
+        cv::Mat residual(const int lambda_low, const int lambda_high, const TreeRule rule = RULE_DIRECT) const;
+
+        /**
+         * Computes the ultimate attribute opening after
+         *
+         * J. Fabrizio & B. Marcotegui (2009): "Fast Implementation of
+         * the Ultimate Opening". In Proceedings of the ISMM 2009,
+         * pp. 272-281.
+         *
+         * For each pixel, residual receives the largest difference
+         * between the openings for two consecutive lambdas up to
+         * max_lambda and scales, of type CV_32S, the attribute of the
+         * component that was removed. On a min-tree, this is the
+         * ultimate closing. The attribute must be increasing.
+         */
+        void ultimateOpening(cv::Mat& residual, cv::Mat& scales, const int max_lambda = std::numeric_limits<int>::max()) const;
+
+        /**
+         * Filters the tree for all of the increasing lambdas with
+         * the direct rule in a single traversal. Channel k of
+         * filtered receives the filtered image for lambdas[k].
+         * Channel k of differential, if given, receives the
+         * residual between the filtered images for lambdas[k - 1]
+         * and lambdas[k], or between the image and the filtered
+         * image for lambdas[0].
+         */
+        void profile(const std::vector<int>& lambdas, cv::Mat& filtered, cv::Mat* differential = 0) const;
+
+    private:
+        ComponentTree(const cv::Mat& img, const TreeType type);
+
+        /**
+         * @returns the filtered level of each pixel in the
+         * image the tree was built on.
+         */
+        std::vector<double> filterLevels(const int lambda, const TreeRule rule, const std::vector<double>& levels) const;
+
+        /**
+         * Accumulates the attributes of all nodes bottom-up. The
+         * pixels of a node precede its canonical pixel in the
+         * order of the tree, and so do all of its descendants.
+         */
+        template <typename A, typename F>
+        static std::vector<int> computeAttributes(const MaxTree& tree, const F& value, TaskControl* control)
+        {
+            const std::vector<int>& parent = tree.parent();
+            const std::vector<int>& order = tree.order();
+            const int cols = tree.image().cols;
+            const int rows = tree.image().rows;
+            const int size = static_cast<int>(order.size());
+
+            std::vector<int> attributes(size, 0);
+            std::vector<ConnectedComponentP_t> nodes(size);
+            std::vector<uchar> processed(size, 0);
+
+            for (int i = 0; i < size; i++) {
+                if (control && i % cols == 0) {
+                    control->checkpoint(static_cast<double>(i) / size);
+                }
+
+                const int p = order[i];
+                const bool canonical = tree.isCanonical(p);
+                const int n = canonical ? p : parent[p];
+
+                ConnectedComponentP_t pixel = ConnectedComponent::create<A>(0, p % cols, p / cols, p);
+                if (nodes[n].empty()) {
+                    nodes[n] = pixel;
+                } else {
+                    pixel->setParent(nodes[n]);
+                }
+
+                // All 4-neighbors processed before p lie in the
+                // same upper level set as p.
+                if (UsesContour<A>::value) {
+                    const int x = p % cols;
+                    const int y = p / cols;
+                    const int neighbors = (y > 0 && processed[p - cols]) + (x > 0 && processed[p - 1])
+                        + (x < cols - 1 && processed[p + 1]) + (y < rows - 1 && processed[p + cols]);
+                    nodes[n]->m_attribute->connect(neighbors);
+                }
+                processed[p] = 1;
+
+                if (canonical) {
+                    attributes[p] = value(*nodes[p]->m_attribute);
+
+                    // Pass the accumulated attribute on to the
+                    // parent node and free the node's set. The
+                    // root's set points to itself.
+                    const int q = parent[p];
+                    if (q == p) {
+                        nodes[p]->m_parent.release();
+                    } else if (nodes[q].empty()) {
+                        nodes[q] = nodes[p];
+                    } else {
+                        nodes[p]->setParent(nodes[q]);
+                    }
+                    nodes[p].release();
+                }
+            }
+            return attributes;
+        }
+
+        MaxTree m_tree;
+        TreeType m_type;
+        std::vector<int> m_attributes;
+    };
+
+    /**
+     * An attribute filter on the component tree. Use it instead
+     * of AttributeFilter for non-increasing attributes.
+     *
+     * Multi-channel images are filtered according to ordering,
+     * marginally with all channels concurrently, or on a single
+     * tree of the lexicographic ranks of their colours.
+     */
+    template <typename A>
+    class TreeFilter
+    {
+    public:
+        TreeFilter(const TreeRule rule = RULE_DIRECT, const ChannelOrdering ordering = ORDER_MARGINAL) :
+            m_rule(rule), m_ordering(ordering)
+        {}
+
+        /**
+         * Performs an attribute opening, i.e. removes bright
+         * components whose attribute is less than lambda.
+         */
+        cv::Mat open(const cv::Mat& img, const int lambda, TaskControl* control = 0) const
+        {
+            return filter(img, lambda, MAX_TREE, control);
+        }
+
+        /**
+         * Performs an attribute closing, i.e. removes dark
+         * components whose attribute is less than lambda.
+         */
+        cv::Mat close(const cv::Mat& img, const int lambda, TaskControl* control = 0) const
+        {
+            return filter(img, lambda, MIN_TREE, control);
+        }
+
+    private:
+        cv::Mat filter(const cv::Mat& img, const int lambda, const TreeType type, TaskControl* control) const
+        {
+            if (img.channels() > 1 && m_ordering == ORDER_LEXICOGRAPHIC) {
+                cv::Mat palette;
+                const cv::Mat ranks = lexicographicRanks(img, palette);
+                return fromLexicographicRanks(ComponentTree::build<A>(ranks, type, control).filter(lambda, m_rule), palette);
+            }
+            return processChannels(img, [&](const cv::Mat& channel) {
+                return ComponentTree::build<A>(channel, type, control).filter(lambda, m_rule);
+            });
+        }
+
+        TreeRule m_rule;
+        ChannelOrdering m_ordering;
+    };
+
+    /**
+     * @returns the bright components of img whose attribute
+     * is less than lambda.
+     */
+    template <typename A>
+    cv::Mat attributeTopHat(const cv::Mat& img, const int lambda, const TreeRule rule = RULE_DIRECT, TaskControl* control = 0)
+    {
+        return ComponentTree::build<A>(img, MAX_TREE, control).residual(lambda, rule);
+    }
+
+    /**
+     * @returns the dark components of img whose attribute
+     * is less than lambda.
+     */
+    template <typename A>
+    cv::Mat attributeBlackTopHat(const cv::Mat& img, const int lambda, const TreeRule rule = RULE_DIRECT, TaskControl* control = 0)
+    {
+        return ComponentTree::build<A>(img, MIN_TREE, control).residual(lambda, rule);
+    }
+
+    /**
+     * Stacks the closing and opening profiles of img,
+     * see morphologicalProfile().
+     */
+    void MORPHOLOGY_EXPORT assembleProfile(const cv::Mat& img, const cv::Mat& openings, const cv::Mat& closings,
+                                           const cv::Mat& open_differences, const cv::Mat& close_differences,
+                                           cv::Mat& profile, cv::Mat* differential);
+
+    /**
+     * Computes the morphological profile of the image img for the
+     * increasing lambdas from one max-tree and one min-tree. For
+     * n lambdas, profile has 2n + 1 channels: the closings for
+     * decreasing lambdas, img and the openings for increasing
+     * lambdas. If differential is given, it receives the 2n
+     * residuals between neighboring channels of profile in the
+     * same order, i.e. the differential profile.
+     *
+     * Multi-band images are profiled band by band, all bands
+     * concurrently, and the profiles of the bands are stacked in
+     * the order of the bands. The total number of channels must
+     * not exceed CV_CN_MAX.
+     */
+    template <typename A>
+    void morphologicalProfile(const cv::Mat& img, const std::vector<int>& lambdas, cv::Mat& profile,
+                              cv::Mat* differential = 0, TaskControl* control = 0)
+    {
+        if (img.channels() > 1) {
+            const int bands = img.channels();
+            const int channels = 2 * static_cast<int>(lambdas.size()) + 1;
+            const int differences = channels - 1;
+            CV_Assert(bands * (channels + (differential ? differences : 0)) <= CV_CN_MAX);
+
+            // Each band returns its profile followed by its
+            // differential profile, if any.
+            const cv::Mat stacked = processChannels(img, [&](const cv::Mat& band) {
+                std::vector<cv::Mat> parts(1);
+                cv::Mat band_differential;
+                morphologicalProfile<A>(band, lambdas, parts[0], differential ? &band_differential : 0, control);
+                if (differential) {
+                    parts.push_back(band_differential);
+                }
+                cv::Mat both;
+                cv::merge(parts, both);
+                return both;
+            });
+
+            std::vector<cv::Mat> planes, profiles, differentials;
+            cv::split(stacked, planes);
+            for (int b = 0, c = 0; b < bands; b++) {
+                profiles.insert(profiles.end(), planes.begin() + c, planes.begin() + c + channels);
+                c += channels;
+                if (differential) {
+                    differentials.insert(differentials.end(), planes.begin() + c, planes.begin() + c + differences);
+                    c += differences;
+                }
+            }
+            cv::merge(profiles, profile);
+            if (differential) {
+                cv::merge(differentials, *differential);
+            }
+            return;
+        }
+
+        cv::Mat openings, closings, open_differences, close_differences;
+        ComponentTree::build<A>(img, MAX_TREE, control).profile(lambdas, openings, differential ? &open_differences : 0);
+        ComponentTree::build<A>(img, MIN_TREE, control).profile(lambdas, closings, differential ? &close_differences : 0);
+        assembleProfile(img, openings, closings, open_differences, close_differences, profile, differential);
+    }
+
+    /**
+     * Computes the ultimate attribute opening of img,
+     * see ComponentTree::ultimateOpening().
+     */
+    template <typename A>
+    void ultimateAttributeOpening(const cv::Mat& img, cv::Mat& residual, cv::Mat& scales,
+                                  const int max_lambda = std::numeric_limits<int>::max(), TaskControl* control = 0)
+    {
+        ComponentTree::build<A>(img, MAX_TREE, control).ultimateOpening(residual, scales, max_lambda);
+    }
+}
+
+#endif // __MORPHOLOGY_COMPONENT_TREE_H
@@ -85,12 +85,14 @@ namespace morphology
          * Find the root of this pixel set and
          * compresses the path to it.
          */
-        static ConnectedComponentP_t findRoot(ConnectedComponentP_t& set);
+        static ConnectedComponentP_t findRoot(ConnectedComponentP_t& set, FilterStatistics* statistics = 0);
 
         /**
-         * Check if this pixel set is still active.
+         * Check if this pixel set is still active. A set that
+         * turned inactive stays inactive, so its attribute is
+         * not tested again.
          */
-        bool isActive(int lambda);
+        bool isActive(int lambda, FilterStatistics* statistics = 0);
     };
 
     /**
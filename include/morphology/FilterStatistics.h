@@ -0,0 +1,89 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_FILTER_STATISTICS_H
+#define __MORPHOLOGY_FILTER_STATISTICS_H
+
+#include <vector>
+
+#include "config.h"
+
+/**
+ * Evaluates expression on a FilterStatistics pointer, if the
+ * pointer is not null. Unless MORPHOLOGY_STATISTICS is defined,
+ * the macro only marks the pointer as used, so the counters cost
+ * nothing in production builds and do not cause warnings.
+ */
+#ifdef MORPHOLOGY_STATISTICS
+  #define MORPHOLOGY_COUNT(statistics, expression) \
+    do { if (statistics) { (statistics)->expression; } } while (0)
+#else
+  #define MORPHOLOGY_COUNT(statistics, expression) do { (void)(statistics); } while (0)
+#endif
+
+namespace morphology
+{
+    /**
+     * Counters collected while building the pixel sets of
+     * an attribute filter. Use them to find out why an input
+     * is expensive to filter.
+     */
+    struct MORPHOLOGY_EXPORT FilterStatistics
+    {
+        // Time spent sorting pixels, in seconds.
+        double sort_time;
+
+        // Number of sets united with another one.
+        long long unions;
+
+        // Number of merges refused because the
+        // neighboring set was not active anymore.
+        long long rejected_merges;
+
+        // Histogram of the number of parent links
+        // followed per call to findRoot().
+        std::vector<long long> path_lengths;
+
+        // Number of calls to Attribute::compute().
+        long long compute_calls;
+
+        // Estimated peak memory of pixel sets
+        // and their attributes, in bytes.
+        size_t peak_node_memory;
+
+        FilterStatistics() :
+            sort_time(0), unions(0), rejected_merges(0), compute_calls(0), peak_node_memory(0)
+        {}
+
+        void addPathLength(const size_t length)
+        {
+            if (path_lengths.size() <= length) {
+                path_lengths.resize(length + 1, 0);
+            }
+            path_lengths[length]++;
+        }
+    };
+}
+
+#endif // __MORPHOLOGY_FILTER_STATISTICS_H
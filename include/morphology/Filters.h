@@ -25,9 +25,12 @@
 #ifndef __MORPHOLOGY_FILTERS_H
 #define __MORPHOLOGY_FILTERS_H
 
+#include <vector>
+
 #include <opencv2/core/core.hpp>
 
 #include "config.h"
+#include "TaskControl.h"
 
 /** Convenience functions for area opening and closing.
  *
@@ -42,6 +45,27 @@ namespace morphology
 
     cv::Mat MORPHOLOGY_EXPORT areaClose(const cv::Mat& input, const int lambda);
     void MORPHOLOGY_EXPORT areaClose(cv::Mat& input, const int lambda);
+
+    /**
+     * Area opening and closing with a CV_32S map of lambdas,
+     * see AttributeFilter.
+     */
+    cv::Mat MORPHOLOGY_EXPORT areaOpen(const cv::Mat& input, const cv::Mat& lambdas);
+    void MORPHOLOGY_EXPORT areaOpen(cv::Mat& input, const cv::Mat& lambdas);
+
+    cv::Mat MORPHOLOGY_EXPORT areaClose(const cv::Mat& input, const cv::Mat& lambdas);
+    void MORPHOLOGY_EXPORT areaClose(cv::Mat& input, const cv::Mat& lambdas);
+
+    /**
+     * Applies an area alternating sequential filter, i.e. an area
+     * opening followed by an area closing for each of the lambdas,
+     * or the other way around if open_first is false. The first
+     * filter works on the flat zones of input and each further
+     * one on the regions that the previous filter left, so the
+     * sequence costs a small multiple of a single filter.
+     */
+    cv::Mat MORPHOLOGY_EXPORT areaAlternatingFilter(const cv::Mat& input, const std::vector<int>& lambdas,
+                                                    const bool open_first = true, TaskControl* control = 0);
 }
 
 #endif // __MORPHOLOGY_FILTERS_H
@@ -0,0 +1,119 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_HIERARCHICAL_QUEUE_H
+#define __MORPHOLOGY_HIERARCHICAL_QUEUE_H
+
+#include <queue>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+
+namespace morphology
+{
+    /**
+     * A hierarchical queue, i.e. one FIFO queue of pixel
+     * indices for each of a small number of integer levels,
+     * after
+     *
+     * F. Meyer (1991): "Un algorithme optimal pour la ligne de
+     * partage des eaux". In Proceedings of the 8e congres AFCET,
+     * pp. 847-857.
+     *
+     * Pixels of the same level are served in the order in
+     * which they were pushed.
+     */
+    class HierarchicalQueue
+    {
+    public:
+        HierarchicalQueue(const int levels) : m_queues(levels), m_size(0) {}
+
+        void push(const int level, const int p)
+        {
+            CV_DbgAssert(0 <= level && level < levels());
+            m_queues[level].push(p);
+            m_size++;
+        }
+
+        /**
+         * Removes and returns the first pixel of level,
+         * which must not be empty.
+         */
+        int pop(const int level)
+        {
+            CV_DbgAssert(!empty(level));
+            const int p = m_queues[level].front();
+            m_queues[level].pop();
+            m_size--;
+            return p;
+        }
+
+        bool empty() const { return m_size == 0; }
+
+        bool empty(const int level) const { return m_queues[level].empty(); }
+
+        int size() const { return m_size; }
+
+        int levels() const { return static_cast<int>(m_queues.size()); }
+
+        /**
+         * @returns the lowest non-empty level not below
+         * level. The queue must not be empty.
+         */
+        int lowest(int level = 0) const
+        {
+            CV_DbgAssert(!empty());
+            while (empty(level)) {
+                level++;
+            }
+            return level;
+        }
+
+        /**
+         * @returns the non-empty level closest to level, or
+         * the lower one of two levels at equal distance. The
+         * queue must not be empty.
+         */
+        int nearest(const int level) const
+        {
+            CV_DbgAssert(!empty());
+            for (int d = 0; ; d++) {
+                if (level - d >= 0 && !empty(level - d)) {
+                    return level - d;
+                }
+                if (level + d < levels() && !empty(level + d)) {
+                    return level + d;
+                }
+            }
+        }
+
+    private:
+        std::vector<std::queue<int> > m_queues;
+        int m_size;
+    };
+}
+
+#endif // __MORPHOLOGY_HIERARCHICAL_QUEUE_H
@@ -0,0 +1,94 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_INCREMENTAL_FILTER_H
+#define __MORPHOLOGY_INCREMENTAL_FILTER_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+
+namespace morphology
+{
+    /**
+     * Filters a sequence of similar images, e.g. video frames,
+     * with an area opening or closing and only recomputes the
+     * parts that changed.
+     *
+     * Whether a component has at least lambda pixels is decided
+     * by the pixels within a distance of lambda - 1, so a change
+     * affects the result only up to that distance, and the result
+     * there only depends on pixels within another lambda - 1.
+     * Changes are collected in tiles, and each changed tile is
+     * filtered with this margin. If the margins would cover more
+     * than half of the image, the whole image is filtered.
+     */
+    class MORPHOLOGY_EXPORT IncrementalAreaFilter
+    {
+    public:
+        IncrementalAreaFilter(const int lambda, const bool closing = false, const int tile_size = 64);
+
+        /**
+         * Filters frame where it differs from the previous one.
+         * The first frame, or a frame of another size, is filtered
+         * completely. Frames must be of type CV_8U.
+         * @returns the filtered frame, which stays valid until the
+         * next call.
+         */
+        const cv::Mat& apply(const cv::Mat& frame);
+
+        /**
+         * Filters frame, which differs from the previous frame
+         * only where changed is non-zero.
+         */
+        const cv::Mat& apply(const cv::Mat& frame, const cv::Mat& changed);
+
+        /**
+         * Forgets the previous frame.
+         */
+        void reset();
+
+        /**
+         * @returns the number of pixels the last call filtered,
+         * including margins.
+         */
+        long long filteredPixels() const { return m_filtered_pixels; }
+
+    private:
+        const cv::Mat& filterAll(const cv::Mat& frame);
+        const cv::Mat& update(const cv::Mat& frame, const std::vector<cv::Rect>& tiles);
+        cv::Mat filter(const cv::Mat& img) const;
+
+        int m_lambda;
+        bool m_closing;
+        int m_tile_size;
+        cv::Mat m_frame;
+        cv::Mat m_result;
+        long long m_filtered_pixels;
+    };
+}
+
+#endif // __MORPHOLOGY_INCREMENTAL_FILTER_H
@@ -0,0 +1,88 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_MAX_TREE_H
+#define __MORPHOLOGY_MAX_TREE_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+
+namespace morphology
+{
+    /**
+     * The max-tree of a grey-scale image, i.e. the tree of the
+     * connected components of its upper level sets, built with
+     * union-find after
+     *
+     * C. Berger, T. Geraud, R. Levillain, N. Widynski, A. Baillard
+     * & E. Bertin (2007): "Effective Component Tree Computation with
+     * Application to Pattern Recognition in Astronomical Imaging".
+     * In Proceedings of the ICIP 2007, pp. 41-44.
+     *
+     * Pixels are addressed by their index in scan-line order and
+     * connected by 8-connectivity. Each node of the tree is
+     * represented by its canonical pixel; the parent of every other
+     * pixel is the canonical pixel of the node it belongs to.
+     * Supported depths are CV_8U, CV_16U and CV_32F.
+     */
+    class MORPHOLOGY_EXPORT MaxTree
+    {
+    public:
+        MaxTree(const cv::Mat& img);
+
+        /**
+         * @returns the continuous image the tree was built on.
+         */
+        const cv::Mat& image() const { return m_image; }
+
+        /**
+         * @returns the parent of each pixel. The root is
+         * its own parent.
+         */
+        const std::vector<int>& parent() const { return m_parent; }
+
+        /**
+         * @returns all pixels sorted by decreasing grey value,
+         * in which every pixel comes before its parent.
+         */
+        const std::vector<int>& order() const { return m_order; }
+
+        int root() const { return m_order.back(); }
+
+        /**
+         * @returns true if p is the canonical pixel of its node.
+         */
+        bool isCanonical(const int p) const;
+
+    private:
+        cv::Mat m_image;
+        std::vector<int> m_parent;
+        std::vector<int> m_order;
+    };
+}
+
+#endif // __MORPHOLOGY_MAX_TREE_H
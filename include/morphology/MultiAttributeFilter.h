@@ -0,0 +1,235 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_MULTI_ATTRIBUTE_FILTER_H
+#define __MORPHOLOGY_MULTI_ATTRIBUTE_FILTER_H
+
+#include <functional>
+#include <type_traits>
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+#include "Attributes.h"
+#include "AttributeFilter.h"
+#include "ComponentTree.h"
+
+namespace morphology
+{
+    /**
+     * Holds one attribute of a VectorAttribute.
+     */
+    template <typename A>
+    struct AttributeMember
+    {
+        cv::Ptr<A> attribute;
+
+        AttributeMember(const ConnectedComponentP_t& pixel) : attribute(new A(pixel)) {}
+    };
+
+    /**
+     * The type of the value of attribute A, as passed
+     * to the predicate of a MultiAttributeFilter.
+     */
+    template <typename A>
+    struct AttributeValue
+    {
+        typedef int type;
+    };
+
+    /**
+     * Accumulates the distinct attributes A... of a connected
+     * set at once.
+     */
+    template <typename... A>
+    class VectorAttribute : public Attribute, private AttributeMember<A>...
+    {
+    public:
+        VectorAttribute(const ConnectedComponentP_t& pixel) :
+            Attribute(pixel), AttributeMember<A>(pixel)...
+        {}
+
+        /**
+         * @returns the attribute B of this set.
+         */
+        template <typename B>
+        const cv::Ptr<B>& get() const
+        {
+            return AttributeMember<B>::attribute;
+        }
+
+        /**
+         * @returns predicate applied to the values of all
+         * attributes, in the order of A...
+         */
+        template <typename P>
+        bool evaluate(const P& predicate)
+        {
+            return predicate(AttributeMember<A>::attribute->compute()...);
+        }
+
+        /**
+         * Returns the value of the first attribute.
+         */
+        virtual int compute()
+        {
+            return computeFirst<A...>();
+        }
+
+        virtual void merge(const cv::Ptr<Attribute>& other)
+        {
+            const cv::Ptr<VectorAttribute> vector_other = static_cast<cv::Ptr<VectorAttribute> >(other);
+            const int expand[] = {(mergeMember<A>(vector_other), 0)...};
+            (void)expand;
+        }
+
+        virtual void connect(const int neighbors)
+        {
+            const int expand[] = {(AttributeMember<A>::attribute->connect(neighbors), 0)...};
+            (void)expand;
+        }
+
+    private:
+        template <typename B, typename... Rest>
+        int computeFirst()
+        {
+            return AttributeMember<B>::attribute->compute();
+        }
+
+        template <typename B>
+        void mergeMember(const cv::Ptr<VectorAttribute>& other)
+        {
+            AttributeMember<B>::attribute->merge(static_cast<cv::Ptr<Attribute> >(other->AttributeMember<B>::attribute));
+        }
+    };
+
+    /**
+     * A vector attribute uses the contour if one of its
+     * attributes does.
+     */
+    template <>
+    struct UsesContour<VectorAttribute<> > : std::false_type {};
+
+    template <typename B, typename... A>
+    struct UsesContour<VectorAttribute<B, A...> > :
+        std::integral_constant<bool, UsesContour<B>::value || UsesContour<VectorAttribute<A...> >::value>
+    {};
+
+    /**
+     * An attribute filter on several attributes at once. A set is
+     * filtered while predicate, called with the values of A...,
+     * returns true, e.g. remove sets smaller than 500 pixels or
+     * with a fill ratio below 40:
+     *
+     * MultiAttributeFilter<Area, FillRatio> filter([](int area, int fill) {
+     *     return area < 500 || fill < 40;
+     * });
+     * filter.open(img, RULE_DIRECT);
+     *
+     * All attributes are accumulated in a single pass, which also
+     * makes the result independent of the order of the criteria.
+     *
+     * Like AttributeFilter, the union-find filters without a rule
+     * stop growing a set once the predicate is false, so they
+     * require an increasing predicate, i.e. one that stays false
+     * for all supersets, like area < 500. Otherwise, the result
+     * depends on the order of merges. Predicates on non-increasing
+     * attributes like FillRatio must pass a TreeRule, which
+     * filters the component tree instead, see ComponentTree.
+     */
+    template <typename... A>
+    class MultiAttributeFilter : private AttributeFilter<VectorAttribute<A...> >
+    {
+    public:
+        typedef VectorAttribute<A...> Attributes;
+        typedef std::function<bool(typename AttributeValue<A>::type...)> Predicate;
+
+        MultiAttributeFilter(const Predicate& predicate) : m_predicate(predicate) {}
+        virtual ~MultiAttributeFilter() {}
+
+        void open(cv::Mat& dst, FilterStatistics* statistics = 0, TaskControl* control = 0) const
+        {
+            AttributeFilter<Attributes>::open(dst, 0, 0, statistics, control);
+        }
+
+        cv::Mat open(const cv::Mat& src, FilterStatistics* statistics = 0, TaskControl* control = 0) const
+        {
+            return AttributeFilter<Attributes>::open(src, 0, 0, statistics, control);
+        }
+
+        void close(cv::Mat& dst, FilterStatistics* statistics = 0, TaskControl* control = 0) const
+        {
+            AttributeFilter<Attributes>::close(dst, 0, 0, statistics, control);
+        }
+
+        cv::Mat close(const cv::Mat& src, FilterStatistics* statistics = 0, TaskControl* control = 0) const
+        {
+            return AttributeFilter<Attributes>::close(src, 0, 0, statistics, control);
+        }
+
+        /**
+         * Removes the nodes of the max-tree for which predicate
+         * is true according to rule.
+         */
+        cv::Mat open(const cv::Mat& src, const TreeRule rule, TaskControl* control = 0) const
+        {
+            return filterTree(src, MAX_TREE, rule, control);
+        }
+
+        /**
+         * Removes the nodes of the min-tree for which predicate
+         * is true according to rule.
+         */
+        cv::Mat close(const cv::Mat& src, const TreeRule rule, TaskControl* control = 0) const
+        {
+            return filterTree(src, MIN_TREE, rule, control);
+        }
+
+    protected:
+        virtual bool isActive(ConnectedComponentP_t& root, FilterWorkspace& workspace) const
+        {
+            if (root->m_active) {
+                MORPHOLOGY_COUNT(workspace.statistics, compute_calls++);
+                root->m_active = static_cast<Attributes&>(*root->m_attribute).evaluate(m_predicate);
+            }
+            return root->m_active;
+        }
+
+    private:
+        cv::Mat filterTree(const cv::Mat& src, const TreeType type, const TreeRule rule, TaskControl* control) const
+        {
+            const Predicate& predicate = m_predicate;
+
+            // Nodes for which the predicate holds get 0
+            // and fail the criterion 0 >= 1.
+            return ComponentTree::build<Attributes>(src, type, [&predicate](Attribute& attribute) {
+                return static_cast<Attributes&>(attribute).evaluate(predicate) ? 0 : 1;
+            }, control).filter(1, rule);
+        }
+
+        Predicate m_predicate;
+    };
+}
+
+#endif // __MORPHOLOGY_MULTI_ATTRIBUTE_FILTER_H
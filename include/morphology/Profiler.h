@@ -0,0 +1,154 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_PROFILER_H
+#define __MORPHOLOGY_PROFILER_H
+
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+/**
+ * Opens a profiling span named name that lasts until the end of
+ * the enclosing scope. Spans nest, so that a span opened within
+ * another one is reported under the path "outer/inner". Unless
+ * MORPHOLOGY_PROFILING is defined, the macro compiles to nothing.
+ */
+#ifdef MORPHOLOGY_PROFILING
+  #define MORPHOLOGY_PROFILE_CONCAT_(a, b) a##b
+  #define MORPHOLOGY_PROFILE_CONCAT(a, b) MORPHOLOGY_PROFILE_CONCAT_(a, b)
+  #define MORPHOLOGY_PROFILE(name) \
+    ::morphology::ScopedSpan MORPHOLOGY_PROFILE_CONCAT(__morphology_span_, __LINE__)(name)
+#else
+  #define MORPHOLOGY_PROFILE(name) do {} while (0)
+#endif
+
+namespace morphology
+{
+    /**
+     * Aggregated timings of all spans with the same path,
+     * in seconds.
+     */
+    struct MORPHOLOGY_EXPORT SpanStatistics
+    {
+        std::string path;
+        size_t count;
+        double total;
+        double min;
+        double mean;
+        double p99;
+        double max;
+    };
+
+    /**
+     * Collects profiling spans. Every thread records into its
+     * own buffer, so threads do not contend while profiling.
+     * Recording is disabled by default and can be enabled at
+     * runtime, either by calling setEnabled() or by setting the
+     * environment variable MORPHOLOGY_PROFILE=1.
+     */
+    class MORPHOLOGY_EXPORT Profiler
+    {
+    public:
+        static bool isEnabled()
+        {
+            return s_enabled.load(std::memory_order_relaxed);
+        }
+
+        static void setEnabled(bool enabled);
+
+        /**
+         * Discards all recorded spans. Spans that are open
+         * while resetting are discarded when they close.
+         */
+        static void reset();
+
+        /**
+         * @returns count, min, mean, 99th percentile and max
+         * of all spans, aggregated by path.
+         */
+        static std::vector<SpanStatistics> statistics();
+
+        /**
+         * Writes the aggregated statistics as JSON.
+         */
+        static void writeJson(std::ostream& out);
+
+        /**
+         * Writes all recorded spans in the Chrome trace event
+         * format, to be loaded into chrome://tracing.
+         */
+        static void writeChromeTrace(std::ostream& out);
+
+        /**
+         * @returns a pointer to a copy of name that is valid
+         * for the lifetime of the program, suitable as span name.
+         */
+        static const char* intern(const std::string& name);
+
+        /**
+         * Opens a span on the calling thread and returns its id.
+         * Prefer MORPHOLOGY_PROFILE or ScopedSpan.
+         */
+        static long long begin(const char* name);
+
+        /**
+         * Closes the span with the given id.
+         */
+        static void end(long long id);
+
+    private:
+        static std::atomic<bool> s_enabled;
+    };
+
+    /**
+     * A span that lasts for the lifetime of the object. If the
+     * profiler is disabled, constructing it costs a single load.
+     */
+    class MORPHOLOGY_EXPORT ScopedSpan
+    {
+    public:
+        explicit ScopedSpan(const char* name) :
+            m_id(Profiler::isEnabled() ? Profiler::begin(name) : -1)
+        {}
+
+        ~ScopedSpan()
+        {
+            if (m_id >= 0) {
+                Profiler::end(m_id);
+            }
+        }
+
+    private:
+        long long m_id;
+
+        ScopedSpan(const ScopedSpan&);
+        ScopedSpan& operator=(const ScopedSpan&);
+    };
+}
+
+#endif // __MORPHOLOGY_PROFILER_H
@@ -26,6 +26,9 @@
 #define __MORPHOLOGY_RECONSTRUCTION_H
 
 #include "config.h"
+#include "TaskControl.h"
+
+#include <vector>
 
 #include <opencv2/core/core.hpp>
 
@@ -36,9 +39,29 @@ namespace morphology
      * L. Vincent, "Morphological grayscale reconstruction in
      * image analysis: applications and efficient algorithms",
      * IEEE Transactions on Image Processing, 1993.
+     *
+     * All algorithms reconstruct the entire image, including
+     * its border. Internally, marker and mask are copied into
+     * work buffers with a one-pixel border of the lowest value
+     * of their depth, i.e. zero for unsigned and the most
+     * negative value for CV_32F images, so callers need not pad
+     * their images themselves.
+     *
+     * Marker and mask must be images of equal size and type.
+     * Supported depths are CV_8U, CV_16U and CV_32F, so elevation
+     * models or fluorescence stacks do not need to be quantized
+     * to eight bits. The channels of multi-channel images are
+     * reconstructed marginally, i.e. each on its own, and
+     * concurrently, one per thread, except for
+     * parallelReconstruct(), which runs them one after another.
+     * There is no lexicographic ordering for reconstructions.
+     *
+     * If control is given, the reconstructions check it once per
+     * strip of rows, iteration or many queue operations, and throw
+     * OperationCancelled when it was cancelled.
      */
 
-    cv::Mat MORPHOLOGY_EXPORT parallelReconstruct(const cv::Mat& marker, const cv::Mat& mask);
+    cv::Mat MORPHOLOGY_EXPORT parallelReconstruct(const cv::Mat& marker, const cv::Mat& mask, TaskControl* control = 0);
 
     /**
      * Sequential grey-scale reconstruction.
@@ -50,7 +73,7 @@ namespace morphology
      *
      * @returns The reconstructed image.
      */
-    cv::Mat MORPHOLOGY_EXPORT sequentialReconstruct(const cv::Mat& marker, const cv::Mat& mask);
+    cv::Mat MORPHOLOGY_EXPORT sequentialReconstruct(const cv::Mat& marker, const cv::Mat& mask, TaskControl* control = 0);
 
     /**
      * Fifo-queue based grey-scale reconstruction.
@@ -60,7 +83,7 @@ namespace morphology
      *
      * @returns The reconstructed image.
      */
-    cv::Mat MORPHOLOGY_EXPORT queueReconstruct(const cv::Mat& marker, const cv::Mat& mask);
+    cv::Mat MORPHOLOGY_EXPORT queueReconstruct(const cv::Mat& marker, const cv::Mat& mask, TaskControl* control = 0);
 
     /**
      * Hybrid grey-scale reconstruction.
@@ -70,15 +93,47 @@ namespace morphology
      *
      * @returns The reconstructed image.
      */
-    cv::Mat MORPHOLOGY_EXPORT hybridReconstruct(const cv::Mat& marker, const cv::Mat& mask);
+    cv::Mat MORPHOLOGY_EXPORT hybridReconstruct(const cv::Mat& marker, const cv::Mat& mask, TaskControl* control = 0);
 
 
     /**
      * These functions compute the h-domes or -basins, respectively,
-     * which are equivalent to regional maxima and minima.
+     * which are equivalent to regional maxima and minima. The
+     * contrast h is given in the value range of src and applies
+     * to every channel.
+     */
+    cv::Mat MORPHOLOGY_EXPORT computeHDomes(const cv::Mat& src, double h);
+    cv::Mat MORPHOLOGY_EXPORT computeHBasins(const cv::Mat& src, double h);
+
+    /**
+     * Batched versions of the above, returning one image per
+     * contrast in h. All images are computed from a single
+     * max-tree of src, so sweeping many contrasts costs one
+     * tree construction plus a linear pass per contrast.
+     */
+    std::vector<cv::Mat> MORPHOLOGY_EXPORT computeHDomes(const cv::Mat& src, const std::vector<double>& h);
+    std::vector<cv::Mat> MORPHOLOGY_EXPORT computeHBasins(const cv::Mat& src, const std::vector<double>& h);
+
+    /**
+     * Hybrid grey-scale reconstruction of volumes, e.g. confocal
+     * stacks, given as slices of equal size and type. Connectivity
+     * is either 6 or 26. The volume is split into slabs of planes
+     * that are reconstructed in parallel.
+     *
+     * @returns The reconstructed slices.
+     */
+    std::vector<cv::Mat> MORPHOLOGY_EXPORT hybridReconstruct(const std::vector<cv::Mat>& marker,
+                                                             const std::vector<cv::Mat>& mask,
+                                                             const int connectivity = 26,
+                                                             TaskControl* control = 0);
+
+    /**
+     * h-domes and -basins of volumes, see above.
      */
-    cv::Mat MORPHOLOGY_EXPORT computeHDomes(const cv::Mat& src, uchar h);
-    cv::Mat MORPHOLOGY_EXPORT computeHBasins(const cv::Mat& src, uchar h);
+    std::vector<cv::Mat> MORPHOLOGY_EXPORT computeHDomes(const std::vector<cv::Mat>& src, const double h,
+                                                         const int connectivity = 26);
+    std::vector<cv::Mat> MORPHOLOGY_EXPORT computeHBasins(const std::vector<cv::Mat>& src, const double h,
+                                                          const int connectivity = 26);
 }
 
 #endif // __MORPHOLOGY_RECONSTRUCTION_H
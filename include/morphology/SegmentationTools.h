@@ -25,13 +25,16 @@
 #ifndef __MORPHOLOGY_SEGMENTATION_TOOLS_H
 #define __MORPHOLOGY_SEGMENTATION_TOOLS_H
 
+#include <algorithm>
 #include <vector>
 
 #include <opencv2/core/core.hpp>
 
 #include <morphology/Attributes.h>
 #include <morphology/AttributeFilter.h>
-#include <morphology/Timer.h>
+#include <morphology/ComponentTree.h>
+#include <morphology/Profiler.h>
+#include <morphology/TaskControl.h>
 
 namespace morphology
 {
@@ -42,24 +45,20 @@ namespace morphology
      * attribute on a given image up to lambda.
      */
     template <typename A>
-    std::vector<int> computeGranulometry(const cv::Mat& img, unsigned int lambda)
+    std::vector<int> computeGranulometry(const cv::Mat& img, unsigned int lambda, TaskControl* control = 0)
     {
         AttributePatternSpectrum<A> aps;
-        std::vector<int> attribute_spectrum;
-        {
-            Timer t("attribute granulometry");
-            attribute_spectrum = aps.close(img, lambda);
-        }
-        return attribute_spectrum;
+        MORPHOLOGY_PROFILE("attribute granulometry");
+        return aps.close(img, lambda, -1, 0, control);
     }
 
     /**
      * Computes the peak of the granulometry
      */
     template <typename A>
-    int ultimateAttribute(const cv::Mat& img)
+    int ultimateAttribute(const cv::Mat& img, TaskControl* control = 0)
     {
-        std::vector<int> spectrum = computeGranulometry<Area>(img, LAMBDA);
+        std::vector<int> spectrum = computeGranulometry<Area>(img, LAMBDA, control);
         const std::vector<int>::iterator max_deflection = max_element(spectrum.begin(), spectrum.end());
         return distance(spectrum.begin(), max_deflection);
     }
@@ -68,37 +67,29 @@ namespace morphology
      * Computes an ultimate attribute opening for
      * given image. Other than image, this operator
      * is parameter-free unless the caller specifies
-     * alpha and epsilon.
+     * alpha and epsilon. If control is given, it is
+     * checked by the granulometry and the tree.
      */
     template <typename A>
-    cv::Mat ultimateAttributeClosing(const cv::Mat& img, const double alpha = 1.0, const double epsilon = 0.0)
+    cv::Mat ultimateAttributeClosing(const cv::Mat& img, const double alpha = 1.0, const double epsilon = 0.0,
+                                     TaskControl* control = 0)
     {
-        Timer t("ultimate attribute closing");
+        MORPHOLOGY_PROFILE("ultimate attribute closing");
 
         // Estimate ultimate attribute.
-        const int attribute = ultimateAttribute<A>(img);
+        const int attribute = ultimateAttribute<A>(img, control);
 
-        AttributeFilter<A> attribute_filter;
+        ComponentTree tree = ComponentTree::build<A>(img, MIN_TREE, control);
 
-        // Remove grain and dirt from the image and
-        // separate cells from each other.
-        cv::Mat i;
-        {
-            Timer t("attribute closing");
-            i = attribute_filter.close(img, attribute * alpha - epsilon);
-        }
-
-        // Close the entire image. This is the
-        // background model.
-        cv::Mat i_bg;
-        {
-            Timer t("background model");
-            i_bg = attribute_filter.close(img, 2 * LAMBDA);
-        }
-
-        // Cells are darker than background, so
-        // remove i from the closed background.
-        return i_bg - i;
+        // Closing the image with 2 * LAMBDA yields the background
+        // model, closing it with the ultimate attribute removes
+        // grain and dirt and separates cells from each other.
+        // Cells are darker than background, so the residual
+        // between both closings contains the cells. Closings
+        // beyond the background model leave no residual.
+        MORPHOLOGY_PROFILE("attribute closing residual");
+        const int lambda = static_cast<int>(std::min(attribute * alpha - epsilon, 2.0 * LAMBDA));
+        return tree.residual(lambda, 2 * LAMBDA);
     }
 }
 #endif // __MORPHOLOGY_SEGMENTATION_TOOLS_H
@@ -0,0 +1,95 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_TASK_CONTROL_H
+#define __MORPHOLOGY_TASK_CONTROL_H
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+#include "config.h"
+
+namespace morphology
+{
+    /**
+     * Thrown by an operation that noticed its cancellation.
+     */
+    class MORPHOLOGY_EXPORT OperationCancelled : public std::exception
+    {
+    public:
+        virtual const char* what() const throw();
+    };
+
+    /**
+     * Receives an estimate of the finished fraction of an
+     * operation in [0, 1]. Estimates never decrease.
+     */
+    typedef std::function<void(const double)> ProgressCallback;
+
+    /**
+     * Lets a client follow and cancel a long-running operation.
+     * Operations check the control at coarse intervals, e.g. per
+     * grey level or per strip of rows, so cancellation takes
+     * effect within a fraction of the total run time.
+     *
+     * cancel() may be called from any thread. The progress
+     * callback runs on a thread of the operation, one call at a
+     * time, as operations may check the control from several
+     * threads, e.g. one per channel.
+     */
+    class MORPHOLOGY_EXPORT TaskControl
+    {
+    public:
+        TaskControl(const ProgressCallback& progress = ProgressCallback());
+
+        void cancel();
+        bool isCancelled() const;
+
+        /**
+         * Reports progress and throws OperationCancelled if the
+         * operation was cancelled. Called by operations.
+         */
+        void checkpoint(const double progress);
+
+    private:
+        std::atomic<bool> m_cancelled;
+        ProgressCallback m_progress;
+        std::mutex m_mutex;
+        double m_reported;
+    };
+
+    /**
+     * Calls checkpoint() on control, unless it is null.
+     */
+    inline void checkpoint(TaskControl* control, const double progress)
+    {
+        if (control) {
+            control->checkpoint(progress);
+        }
+    }
+}
+
+#endif // __MORPHOLOGY_TASK_CONTROL_H
@@ -0,0 +1,85 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_THREAD_POOL_H
+#define __MORPHOLOGY_THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+
+namespace morphology
+{
+    /**
+     * A fixed set of worker threads that run submitted tasks
+     * in submission order. Workers live as long as the pool,
+     * so batches do not pay for thread creation.
+     */
+    class MORPHOLOGY_EXPORT ThreadPool
+    {
+    public:
+        /**
+         * Starts the given number of workers, or one per
+         * hardware thread if threads is not positive.
+         */
+        explicit ThreadPool(const int threads = 0);
+
+        /**
+         * Finishes all submitted tasks and joins the workers.
+         */
+        ~ThreadPool();
+
+        /**
+         * Queues a task. Tasks must not throw.
+         */
+        void submit(const std::function<void()>& task);
+
+        int size() const { return static_cast<int>(m_workers.size()); }
+
+        /**
+         * @returns a pool shared by the whole process, with
+         * one worker per hardware thread.
+         */
+        static ThreadPool& shared();
+
+    private:
+        ThreadPool(const ThreadPool&);
+        ThreadPool& operator=(const ThreadPool&);
+
+        void work();
+
+        std::vector<std::thread> m_workers;
+        std::queue<std::function<void()> > m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_available;
+        bool m_stopping;
+    };
+}
+
+#endif // __MORPHOLOGY_THREAD_POOL_H
@@ -27,17 +27,22 @@
 
 #include <string>
 
+#include "config.h"
+#include "Profiler.h"
+
 namespace morphology
 {
-    class Timer
+    /**
+     * A profiling span with a run-time name. Timings are
+     * recorded by the Profiler instead of being printed.
+     */
+    class MORPHOLOGY_EXPORT Timer
     {
     public:
         Timer(const std::string& name);
-        ~Timer();
 
     private:
-        std::string m_name;
-        long m_start;
+        ScopedSpan m_span;
     };
 }
 #endif // __MORPHOLOGY_TIMER_H
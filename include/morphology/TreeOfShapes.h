@@ -0,0 +1,192 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_TREE_OF_SHAPES_H
+#define __MORPHOLOGY_TREE_OF_SHAPES_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+#include "Attributes.h"
+#include "ConnectedComponent.h"
+#include "TaskControl.h"
+
+namespace morphology
+{
+    /**
+     * The tree of shapes of a grey-scale image, i.e. the tree of
+     * the connected components of its upper and lower level sets
+     * with their holes filled, computed after
+     *
+     * T. Geraud, E. Carlinet, S. Crozet & L. Najman (2013): "A
+     * Quasi-linear Algorithm to Compute the Tree of Shapes of n-D
+     * Images". In Proceedings of the ISMM 2013, pp. 98-110.
+     *
+     * The image is padded with the median of its border and
+     * immersed in a grid of twice its resolution, in which faces
+     * between pixels span the values of their pixels. Points of
+     * this grid are sorted by propagation from the border with a
+     * hierarchical queue and then united like in a max-tree.
+     *
+     * Bright and dark components are nodes of the same tree, so
+     * filters on it are self-dual. Points are addressed by their
+     * index on the grid in scan-line order. Only CV_8U images are
+     * supported.
+     */
+    class MORPHOLOGY_EXPORT TreeOfShapes
+    {
+    public:
+        TreeOfShapes(const cv::Mat& img, TaskControl* control = 0);
+
+        /**
+         * @returns the size of the image the tree was built on.
+         */
+        cv::Size size() const { return m_size; }
+
+        /**
+         * @returns the index of image pixel (x, y) on the grid.
+         */
+        int point(const int x, const int y) const { return (2 * y + 2) * m_cols + 2 * x + 2; }
+
+        /**
+         * @returns true if point p is a pixel of the image.
+         */
+        bool isPixel(const int p) const;
+
+        /**
+         * @returns the parent of each point. The root is
+         * its own parent.
+         */
+        const std::vector<int>& parent() const { return m_parent; }
+
+        /**
+         * @returns all points, each after its parent.
+         */
+        const std::vector<int>& order() const { return m_order; }
+
+        /**
+         * @returns the grey level of each point.
+         */
+        const std::vector<uchar>& levels() const { return m_levels; }
+
+        int root() const { return m_order.front(); }
+
+        /**
+         * @returns true if p is the canonical point of its node.
+         */
+        bool isCanonical(const int p) const
+        {
+            return p == m_parent[p] || m_levels[p] != m_levels[m_parent[p]];
+        }
+
+        /**
+         * @returns the number of image pixels in the shape of
+         * each canonical point.
+         */
+        std::vector<int> areas() const;
+
+        /**
+         * @returns the attribute A of the shape of each canonical
+         * point. Contour attributes are not supported, as shapes
+         * are not built from neighboring pixels.
+         */
+        template <typename A>
+        std::vector<int> attributes() const
+        {
+            static_assert(!UsesContour<A>::value, "contour attributes are not supported on the tree of shapes");
+
+            std::vector<int> attributes(m_parent.size(), 0);
+            std::vector<ConnectedComponentP_t> nodes(m_parent.size());
+
+            // Children come after their parents.
+            for (std::vector<int>::const_reverse_iterator it = m_order.rbegin(); it != m_order.rend(); it++) {
+                const int p = *it;
+                const int n = isCanonical(p) ? p : m_parent[p];
+
+                if (isPixel(p)) {
+                    const int x = (p % m_cols) / 2 - 1;
+                    const int y = (p / m_cols) / 2 - 1;
+                    ConnectedComponentP_t pixel = ConnectedComponent::create<A>(0, x, y, x + y * m_size.width);
+                    if (nodes[n].empty()) {
+                        nodes[n] = pixel;
+                    } else {
+                        pixel->setParent(nodes[n]);
+                    }
+                }
+
+                // All points of the node and of its descendants
+                // were seen, so pass the attribute on.
+                if (p == n && !nodes[p].empty()) {
+                    attributes[p] = nodes[p]->m_attribute->compute();
+                    const int q = m_parent[p];
+                    if (q == p) {
+                        nodes[p]->m_parent.release();
+                    } else if (nodes[q].empty()) {
+                        nodes[q] = nodes[p];
+                    } else {
+                        nodes[p]->setParent(nodes[q]);
+                    }
+                    nodes[p].release();
+                }
+            }
+            return attributes;
+        }
+
+        /**
+         * Removes all shapes whose attribute is less than lambda,
+         * given the attribute of each canonical point.
+         */
+        cv::Mat filter(const std::vector<int>& attributes, const int lambda) const;
+
+    private:
+        cv::Size m_size;
+        int m_cols;
+        std::vector<int> m_parent;
+        std::vector<int> m_order;
+        std::vector<uchar> m_levels;
+    };
+
+    /**
+     * Removes bright and dark components of img whose attribute
+     * is less than lambda in a single pass, so the result does not
+     * depend on the order of an opening and a closing.
+     */
+    template <typename A>
+    cv::Mat selfDualFilter(const cv::Mat& img, const int lambda, TaskControl* control = 0)
+    {
+        const TreeOfShapes tree(img, control);
+        return tree.filter(tree.attributes<A>(), lambda);
+    }
+
+    template <>
+    inline cv::Mat selfDualFilter<Area>(const cv::Mat& img, const int lambda, TaskControl* control)
+    {
+        const TreeOfShapes tree(img, control);
+        return tree.filter(tree.areas(), lambda);
+    }
+}
+
+#endif // __MORPHOLOGY_TREE_OF_SHAPES_H
@@ -27,17 +27,22 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <limits>
 #include <vector>
 
 #include <opencv2/core/core.hpp>
 
+#include "config.h"
+
 namespace morphology
 {
     /**
      * @returns true if one of the neighbors (union of raster
-     * and anti-raster direction) of p is zero.
+     * and anti-raster direction) of p is zero. The function
+     * does not check bounds, so p must not lie on the border
+     * of the image; pad the image if necessary.
      */
-    inline bool isBoundary(const uchar* p, const uchar step)
+    inline bool isBoundary(const uchar* p, const int step)
     {
         const uchar neighbors[] = {*(p - step - 1), *(p - step), *(p - step + 1),
                                    *(p - 1), *(p + 1),
@@ -51,28 +56,25 @@ namespace morphology
     }
 
     /**
-     * @returns the negative of an image.
+     * @returns the smallest value of the pixel type T.
      */
-    inline cv::Mat negative(const cv::Mat& src)
+    template <typename T>
+    inline T lowest()
     {
-        return (cv::Mat::ones(src.size(), src.type()) * 255) - src;
+        return std::numeric_limits<T>::is_integer ? std::numeric_limits<T>::min() : -std::numeric_limits<T>::max();
     }
 
-    inline cv::Mat& negative(cv::Mat& dst)
-    {
-        const uchar step = dst.step[0] / dst.step[1];
-
-        for (int y = 0; y < dst.rows - 1; y++) {
-            uchar* p = dst.ptr(y);
-            const uchar* p_end = p+ dst.cols;
+    /**
+     * @returns the negative of an image. Unsigned images are
+     * mirrored at the maximum value of their depth, floating
+     * point images are negated.
+     */
+    cv::Mat MORPHOLOGY_EXPORT negative(const cv::Mat& src);
 
-            while (p != p_end) {
-                *p = 255 - *p;
-                p++;
-            }
-        }
-        return dst;
-    }
+    /**
+     * Replaces dst by its negative, see above.
+     */
+    MORPHOLOGY_EXPORT cv::Mat& negative(cv::Mat& dst);
 
     /**
      * @returns the radius of this area.
@@ -0,0 +1,78 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_WATERSHED_H
+#define __MORPHOLOGY_WATERSHED_H
+
+#include <opencv2/core/core.hpp>
+
+#include "config.h"
+#include "TaskControl.h"
+
+namespace morphology
+{
+    /**
+     * Labels the 8-connected components of the non-zero pixels
+     * of the CV_8U image mask in a single union-find pass.
+     *
+     * @returns a CV_32S image with the labels 1 to n in
+     * scan-line order of the components and 0 elsewhere.
+     */
+    cv::Mat MORPHOLOGY_EXPORT labelComponents(const cv::Mat& mask);
+
+    /**
+     * Marker-controlled watershed of the CV_8U image img by
+     * flooding with a hierarchical queue, after
+     *
+     * F. Meyer (1991): "Un algorithme optimal pour la ligne de
+     * partage des eaux". In Proceedings of the 8e congres AFCET,
+     * pp. 847-857.
+     *
+     * markers is either a CV_32S image of labels, where pixels
+     * with a positive label are markers, or a CV_8U image whose
+     * 8-connected non-zero components are the markers, see
+     * labelComponents(). The basins grow from the markers in
+     * order of increasing level, each pixel joining the first
+     * basin that reaches it, in time linear in the number of
+     * pixels. If mask is given, basins only grow over its
+     * non-zero pixels, so touching objects of a foreground mask
+     * are split without tracing their contours.
+     *
+     * @returns a CV_32S image with the label of the basin of each
+     * pixel, and 0 for pixels no marker reaches.
+     */
+    cv::Mat MORPHOLOGY_EXPORT watershed(const cv::Mat& img, const cv::Mat& markers, const cv::Mat& mask = cv::Mat(),
+                                        TaskControl* control = 0);
+
+    /**
+     * Watershed of img with its h-minima as markers, i.e. the
+     * regional minima of img filled up by computeHBasins(img, h).
+     * Minima with a dynamic of less than h, e.g. noise within a
+     * cell, do not get a basin of their own. h must be at least 1.
+     */
+    cv::Mat MORPHOLOGY_EXPORT watershed(const cv::Mat& img, const double h, const cv::Mat& mask = cv::Mat(),
+                                        TaskControl* control = 0);
+}
+
+#endif // __MORPHOLOGY_WATERSHED_H
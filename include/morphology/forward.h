@@ -31,6 +31,7 @@ namespace morphology
 {
     class Attribute;
     class ConnectedComponent;
+    struct FilterStatistics;
     typedef cv::Ptr<ConnectedComponent> ConnectedComponentP_t;
 }
 
@@ -0,0 +1,258 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/AlphaTree.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "UnionFind.h"
+
+using namespace cv;
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        const int levels = 256;
+
+        /**
+         * @returns the largest absolute difference between
+         * the channels of two pixels.
+         */
+        inline uchar dissimilarity(const uchar* a, const uchar* b, const int cn)
+        {
+            int d = 0;
+            for (int c = 0; c < cn; c++) {
+                d = std::max(d, std::abs(a[c] - b[c]));
+            }
+            return static_cast<uchar>(d);
+        }
+    } // namespace
+
+    AlphaTree::AlphaTree(const Mat& img, TaskControl* control) :
+        m_size(img.size())
+    {
+        CV_Assert(img.depth() == CV_8U && !img.empty());
+
+        const int cols = img.cols;
+        const int rows = img.rows;
+        const int cn = img.channels();
+        const int size = rows * cols;
+
+        // Edge 2p joins pixel p to its right neighbor,
+        // edge 2p + 1 to the neighbor below it.
+        vector<uchar> weights(2 * size, 0);
+        vector<int> offsets(levels + 1, 0);
+        for (int y = 0; y < rows; y++) {
+            checkpoint(control, 0.25 * y / rows);
+
+            const uchar* row = img.ptr<uchar>(y);
+            const uchar* below = y + 1 < rows ? img.ptr<uchar>(y + 1) : 0;
+            for (int x = 0; x < cols; x++) {
+                const int p = y * cols + x;
+                if (x + 1 < cols) {
+                    weights[2 * p] = dissimilarity(row + x * cn, row + (x + 1) * cn, cn);
+                    offsets[weights[2 * p] + 1]++;
+                }
+                if (below) {
+                    weights[2 * p + 1] = dissimilarity(row + x * cn, below + x * cn, cn);
+                    offsets[weights[2 * p + 1] + 1]++;
+                }
+            }
+        }
+
+        // Sort the edges by counting sort, which keeps
+        // edges of equal weight in scan-line order.
+        for (int w = 0; w < levels; w++) {
+            offsets[w + 1] += offsets[w];
+        }
+        vector<int> edges(offsets[levels]);
+        for (int p = 0; p < size; p++) {
+            if (p % cols + 1 < cols) {
+                edges[offsets[weights[2 * p]]++] = 2 * p;
+            }
+            if (p / cols + 1 < rows) {
+                edges[offsets[weights[2 * p + 1]]++] = 2 * p + 1;
+            }
+        }
+
+        // Unite the pixels along the sorted edges. Each set has
+        // a node, which is its pixel or the node it last grew
+        // into. A set grows into a new node, unless it or the
+        // set it merges with already has a node at the same
+        // alpha. Nodes that are merged into a node at the same
+        // alpha are redundant and removed below.
+        vector<int> parent(size, -1);
+        vector<uchar> alphas(size, 0);
+        vector<int> areas(size, 1);
+        {
+            vector<int> zpar(size);
+            vector<uchar> rank(size, 0);
+            vector<int> node(size);
+            for (int p = 0; p < size; p++) {
+                zpar[p] = p;
+                node[p] = p;
+            }
+
+            for (size_t i = 0; i < edges.size(); i++) {
+                if (i % cols == 0) {
+                    checkpoint(control, 0.25 + 0.5 * i / edges.size());
+                }
+
+                const int e = edges[i];
+                const int p = e / 2;
+                int r_p = findRoot(zpar, p);
+                int r_q = findRoot(zpar, e % 2 ? p + cols : p + 1);
+                if (r_p == r_q) {
+                    continue;
+                }
+
+                const uchar alpha = weights[e];
+                int n_p = node[r_p];
+                int n_q = node[r_q];
+                if (n_p < size || alphas[n_p] != alpha) {
+                    if (n_q >= size && alphas[n_q] == alpha) {
+                        std::swap(n_p, n_q);
+                    } else {
+                        const int n = static_cast<int>(parent.size());
+                        const int area = areas[n_p];
+                        parent.push_back(-1);
+                        alphas.push_back(alpha);
+                        areas.push_back(area);
+                        parent[n_p] = n;
+                        n_p = n;
+                    }
+                }
+                parent[n_q] = n_p;
+                areas[n_p] += areas[n_q];
+
+                // Union by rank.
+                if (rank[r_p] < rank[r_q]) {
+                    std::swap(r_p, r_q);
+                } else if (rank[r_p] == rank[r_q]) {
+                    rank[r_p]++;
+                }
+                zpar[r_q] = r_p;
+                node[r_p] = n_p;
+            }
+
+            const int root = node[findRoot(zpar, 0)];
+            parent[root] = root;
+        }
+
+        // Nodes are created in order of increasing alpha, so
+        // canonical nodes come before their parents. A node is
+        // canonical if its parent has a higher alpha.
+        const int count = static_cast<int>(parent.size());
+        vector<int> canonical(count);
+        vector<int> index(count, -1);
+        int next = 0;
+        for (int n = 0; n < count; n++) {
+            const bool redundant = n >= size && parent[n] != n && alphas[parent[n]] == alphas[n];
+            canonical[n] = redundant ? parent[n] : n;
+            if (!redundant) {
+                index[n] = next++;
+            }
+        }
+
+        m_parent.resize(next);
+        m_alphas.resize(next);
+        m_areas.resize(next);
+        for (int n = 0; n < count; n++) {
+            if (n % cols == 0) {
+                checkpoint(control, 0.75 + 0.25 * n / count);
+            }
+
+            if (index[n] >= 0) {
+                m_parent[index[n]] = index[findRoot(canonical, parent[n])];
+                m_alphas[index[n]] = alphas[n];
+                m_areas[index[n]] = areas[n];
+            }
+        }
+        checkpoint(control, 1);
+    }
+
+    Mat AlphaTree::cut(const int alpha, const vector<int>& attributes, const int lambda) const
+    {
+        CV_Assert(alpha >= 0 && attributes.size() == m_parent.size());
+
+        // A node lies in a zone if its parent's alpha is at most
+        // alpha, and is a zone itself if only its own alpha is.
+        // Walk up from the zones and pass the largest kept zone
+        // on to the nodes above the cut.
+        const int count = static_cast<int>(m_parent.size());
+        vector<int> largest(count, -1);
+        for (int n = 0; n < count; n++) {
+            const int q = m_parent[n];
+            if (q != n && m_alphas[q] <= alpha) {
+                continue;
+            }
+            if (m_alphas[n] <= alpha && attributes[n] >= lambda) {
+                largest[n] = n;
+            }
+            if (q != n && largest[n] >= 0 && (largest[q] < 0 || m_areas[largest[n]] > m_areas[largest[q]])) {
+                largest[q] = largest[n];
+            }
+        }
+
+        // Walk down from the root. Pixels take the region of
+        // their zone, and removed zones the region of the
+        // largest kept zone of their closest ancestor.
+        vector<int> region(count);
+        for (int n = count - 1; n >= 0; n--) {
+            const int q = m_parent[n];
+            if (q != n && m_alphas[q] <= alpha) {
+                region[n] = region[q];
+            } else if (m_alphas[n] <= alpha) {
+                region[n] = attributes[n] >= lambda || q == n ? n : region[q];
+            } else {
+                region[n] = largest[n] >= 0 ? largest[n] : (q == n ? n : region[q]);
+            }
+        }
+
+        // Label the regions in scan-line order of
+        // their first pixel.
+        vector<int> label(count, -1);
+        int labels = 0;
+        Mat dst(m_size, CV_32S);
+        for (int y = 0; y < m_size.height; y++) {
+            int* d = dst.ptr<int>(y);
+            for (int x = 0; x < m_size.width; x++) {
+                int& l = label[region[y * m_size.width + x]];
+                if (l < 0) {
+                    l = labels++;
+                }
+                d[x] = l;
+            }
+        }
+        return dst;
+    }
+
+    Mat AlphaTree::cut(const int alpha, const int min_area) const
+    {
+        return cut(alpha, m_areas, min_area);
+    }
+}
@@ -0,0 +1,303 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/Filters.h>
+
+#include <algorithm>
+
+#include <morphology/Profiler.h>
+
+#include "UnionFind.h"
+
+using namespace cv;
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        /**
+         * The flat zones of an image, i.e. its maximal connected
+         * sets of equal value, and their adjacency. An attribute
+         * filter never splits a flat zone, so after the first step
+         * of a sequence of filters, each further step works on the
+         * regions left by the previous one instead of on pixels.
+         */
+        struct RegionGraph
+        {
+            vector<int> values;
+            vector<int> sizes;
+            vector<vector<int> > neighbors;
+        };
+
+        /**
+         * Replaces each set in zpar by a label in [0, count)
+         * and returns count.
+         */
+        int relabel(vector<int>& zpar, vector<int>& labels)
+        {
+            const int size = static_cast<int>(zpar.size());
+            labels.assign(size, -1);
+            int count = 0;
+            for (int p = 0; p < size; p++) {
+                const int root = findRoot(zpar, p);
+                if (labels[root] < 0) {
+                    labels[root] = count++;
+                }
+                labels[p] = labels[root];
+            }
+            return count;
+        }
+
+        void sortNeighbors(RegionGraph& graph)
+        {
+            for (size_t r = 0; r < graph.neighbors.size(); r++) {
+                vector<int>& n = graph.neighbors[r];
+                sort(n.begin(), n.end());
+                n.erase(unique(n.begin(), n.end()), n.end());
+            }
+        }
+
+        /**
+         * Labels the 8-connected flat zones of img and
+         * builds their graph.
+         */
+        RegionGraph buildGraph(const Mat& img, vector<int>& labels)
+        {
+            const int size = img.rows * img.cols;
+            vector<int> zpar(size);
+            for (int p = 0; p < size; p++) {
+                zpar[p] = p;
+            }
+
+            // Each pixel looks at the neighbors after it.
+            const int dx[] = {1, -1, 0, 1};
+            const int dy[] = {0, 1, 1, 1};
+            for (int y = 0; y < img.rows; y++) {
+                const uchar* row = img.ptr(y);
+                for (int x = 0; x < img.cols; x++) {
+                    for (int i = 0; i < 4; i++) {
+                        const int u = x + dx[i];
+                        const int v = y + dy[i];
+                        if (u >= 0 && u < img.cols && v < img.rows && row[x] == img.at<uchar>(v, u)) {
+                            const int a = findRoot(zpar, x + y * img.cols);
+                            const int b = findRoot(zpar, u + v * img.cols);
+                            zpar[std::max(a, b)] = std::min(a, b);
+                        }
+                    }
+                }
+            }
+
+            RegionGraph graph;
+            const int count = relabel(zpar, labels);
+            graph.values.resize(count);
+            graph.sizes.assign(count, 0);
+            graph.neighbors.resize(count);
+
+            for (int y = 0; y < img.rows; y++) {
+                for (int x = 0; x < img.cols; x++) {
+                    const int r = labels[x + y * img.cols];
+                    graph.values[r] = img.at<uchar>(y, x);
+                    graph.sizes[r]++;
+
+                    for (int i = 0; i < 4; i++) {
+                        const int u = x + dx[i];
+                        const int v = y + dy[i];
+                        if (u >= 0 && u < img.cols && v < img.rows) {
+                            const int n = labels[u + v * img.cols];
+                            if (n != r) {
+                                graph.neighbors[r].push_back(n);
+                                graph.neighbors[n].push_back(r);
+                            }
+                        }
+                    }
+                }
+            }
+            sortNeighbors(graph);
+            return graph;
+        }
+
+        /**
+         * Orders regions by decreasing value, or by increasing
+         * value for closings.
+         */
+        struct RegionOrder
+        {
+            const vector<int>& values;
+            const bool closing;
+
+            RegionOrder(const vector<int>& _values, const bool _closing) : values(_values), closing(_closing) {}
+
+            bool operator()(const int l, const int r) const
+            {
+                if (values[l] != values[r]) {
+                    return closing ? values[l] < values[r] : values[l] > values[r];
+                }
+                return l < r;
+            }
+        };
+
+        /**
+         * Performs an area opening or closing on the graph with
+         * the max-tree of its regions, weighted by their sizes.
+         * @returns the new value of each region.
+         */
+        vector<int> filterGraph(const RegionGraph& graph, const int lambda, const bool closing)
+        {
+            const int count = static_cast<int>(graph.values.size());
+            vector<int> order(count);
+            for (int r = 0; r < count; r++) {
+                order[r] = r;
+            }
+            sort(order.begin(), order.end(), RegionOrder(graph.values, closing));
+
+            vector<int> parent(count, -1);
+            vector<int> zpar(count);
+            vector<int> area(graph.sizes);
+            for (vector<int>::const_iterator it = order.begin(); it != order.end(); it++) {
+                const int r = *it;
+                parent[r] = r;
+                zpar[r] = r;
+
+                const vector<int>& neighbors = graph.neighbors[r];
+                for (vector<int>::const_iterator n = neighbors.begin(); n != neighbors.end(); n++) {
+                    if (parent[*n] < 0) {
+                        continue;
+                    }
+
+                    const int root = findRoot(zpar, *n);
+                    if (root != r) {
+                        parent[root] = r;
+                        zpar[root] = r;
+                        area[r] += area[root];
+                    }
+                }
+            }
+
+            // A region keeps its value if the component of its
+            // level set has at least lambda pixels. Otherwise,
+            // it takes the value of its parent, top-down.
+            const vector<int>& values = graph.values;
+            vector<int> filtered(count);
+            for (vector<int>::const_reverse_iterator it = order.rbegin(); it != order.rend(); it++) {
+                const int r = *it;
+                const int q = parent[r];
+                if (r == q) {
+                    filtered[r] = values[r];
+                } else if (values[q] == values[r]) {
+                    // Not the canonical region of its node.
+                    filtered[r] = filtered[q];
+                } else {
+                    filtered[r] = area[r] >= lambda ? values[r] : filtered[q];
+                }
+            }
+            return filtered;
+        }
+
+        /**
+         * Merges adjacent regions of equal value.
+         * @returns the new graph and, in mapping, the
+         * new region of each region.
+         */
+        RegionGraph contract(const RegionGraph& graph, const vector<int>& values, vector<int>& mapping)
+        {
+            const int count = static_cast<int>(values.size());
+            vector<int> zpar(count);
+            for (int r = 0; r < count; r++) {
+                zpar[r] = r;
+            }
+            for (int r = 0; r < count; r++) {
+                const vector<int>& neighbors = graph.neighbors[r];
+                for (vector<int>::const_iterator n = neighbors.begin(); n != neighbors.end(); n++) {
+                    if (values[*n] == values[r]) {
+                        const int a = findRoot(zpar, r);
+                        const int b = findRoot(zpar, *n);
+                        zpar[std::max(a, b)] = std::min(a, b);
+                    }
+                }
+            }
+
+            RegionGraph contracted;
+            const int contracted_count = relabel(zpar, mapping);
+            contracted.values.resize(contracted_count);
+            contracted.sizes.assign(contracted_count, 0);
+            contracted.neighbors.resize(contracted_count);
+            for (int r = 0; r < count; r++) {
+                const int c = mapping[r];
+                contracted.values[c] = values[r];
+                contracted.sizes[c] += graph.sizes[r];
+
+                const vector<int>& neighbors = graph.neighbors[r];
+                for (vector<int>::const_iterator n = neighbors.begin(); n != neighbors.end(); n++) {
+                    if (mapping[*n] != c) {
+                        contracted.neighbors[c].push_back(mapping[*n]);
+                    }
+                }
+            }
+            sortNeighbors(contracted);
+            return contracted;
+        }
+    } // namespace
+
+    Mat areaAlternatingFilter(const Mat& input, const vector<int>& lambdas, const bool open_first, TaskControl* control)
+    {
+        CV_Assert(input.type() == CV_8U);
+        MORPHOLOGY_PROFILE("area alternating sequential filter");
+
+        vector<int> labels;
+        RegionGraph graph = buildGraph(input, labels);
+
+        // The current region of each flat zone of the input.
+        vector<int> regions(graph.values.size());
+        for (size_t r = 0; r < regions.size(); r++) {
+            regions[r] = static_cast<int>(r);
+        }
+
+        const int steps = 2 * static_cast<int>(lambdas.size());
+        for (int step = 0; step < steps; step++) {
+            checkpoint(control, static_cast<double>(step) / steps);
+
+            const bool closing = (step % 2 == 0) != open_first;
+            const vector<int> filtered = filterGraph(graph, lambdas[step / 2], closing);
+            if (filtered == graph.values) {
+                continue;
+            }
+
+            vector<int> mapping;
+            graph = contract(graph, filtered, mapping);
+            for (size_t r = 0; r < regions.size(); r++) {
+                regions[r] = mapping[regions[r]];
+            }
+        }
+
+        Mat dst(input.size(), CV_8U);
+        for (int y = 0; y < dst.rows; y++) {
+            uchar* d = dst.ptr(y);
+            for (int x = 0; x < dst.cols; x++) {
+                d[x] = static_cast<uchar>(graph.values[regions[labels[x + y * dst.cols]]]);
+            }
+        }
+        return dst;
+    }
+}
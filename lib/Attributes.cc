@@ -25,6 +25,7 @@
 #include <morphology/Attributes.h>
 
 #include <morphology/ConnectedComponent.h>
+#include <morphology/Utils.h>
 
 using namespace cv;
 using namespace std;
@@ -40,6 +41,11 @@ namespace morphology
         return m_area;
     }
 
+    bool Area::lessThan(const int lambda)
+    {
+        return m_area < lambda;
+    }
+
     void Area::merge(const Ptr<Attribute>& other)
     {
         const Ptr<Area> area_other = static_cast<Ptr<Area> >(other);
@@ -67,20 +73,27 @@ namespace morphology
     int EqualSideLength::compute()
     {
         // Add one to avoid division by zero.
-        const double width = x_max - x_min + 1;
-        const double height = y_max - y_min + 1;
+        const int width = x_max - x_min + 1;
+        const int height = y_max - y_min + 1;
 
         // We do not want to know the actual ratio,
         // but a measurement of how circular the object is.
-        const double equality = width > height ? height / width : width / height;
+        // Integer division rounds down like lessThan(), so
+        // both agree at the boundary, and equal sides give
+        // exactly 100.
+        const int equality = static_cast<int>(100LL * min(width, height) / max(width, height));
 
-        CV_Assert(equality <= 1);
+        CV_DbgAssert(equality <= 100);
+        return equality;
+    }
 
-        // We must return an int as this is
-        // value also used as index. We always
-        // round down deliberately. Otherwise,
-        // we'd get 101 for equal sides.
-        return static_cast<int>(equality * 100);
+    bool EqualSideLength::lessThan(const int lambda)
+    {
+        // floor(100 * short / long) < lambda
+        // iff 100 * short < lambda * long.
+        const int width = x_max - x_min + 1;
+        const int height = y_max - y_min + 1;
+        return 100LL * min(width, height) < static_cast<long long>(lambda) * max(width, height);
     }
 
     FillRatio::FillRatio(const ConnectedComponentP_t& pixel) :
@@ -90,12 +103,20 @@ namespace morphology
     int FillRatio::compute()
     {
         // Add one to avoid division by zero.
-        const double width = x_max - x_min + 1;
-        const double height = y_max - y_min + 1;
+        const long long width = x_max - x_min + 1;
+        const long long height = y_max - y_min + 1;
+
+        // Round down in integers, like lessThan().
+        const int fill = static_cast<int>(100LL * m_area / (width * height));
+        CV_DbgAssert(fill <= 100);
+        return fill;
+    }
 
-        double fill = m_area / (width * height);
-        CV_Assert(fill <= 1);
-        return static_cast<int>(fill * 100);
+    bool FillRatio::lessThan(const int lambda)
+    {
+        const long long width = x_max - x_min + 1;
+        const long long height = y_max - y_min + 1;
+        return 100LL * m_area < lambda * width * height;
     }
 
     void FillRatio::merge(const Ptr<Attribute>& other)
@@ -104,106 +125,165 @@ namespace morphology
         Area::merge(other);
     }
 
-    inline int computeHash(const int x, const int y)
+    ContourAttribute::ContourAttribute(const ConnectedComponentP_t& pixel) :
+        Attribute(pixel), m_perimeter(4)
+    {}
+
+    void ContourAttribute::merge(const Ptr<Attribute>& other)
     {
-        return ((x + y) * (x + y + 1)) / 2 + y;
+        const Ptr<ContourAttribute> ca_other = static_cast<Ptr<ContourAttribute> >(other);
+        m_perimeter += ca_other->m_perimeter;
     }
 
-    ContourAttribute::HashedPoint* ContourAttribute::getPoint(const int x, const int y)
+    void ContourAttribute::connect(const int neighbors)
     {
-        static map<int, HashedPoint> points;
-        int hash = computeHash(x, y);
+        // Each shared edge was counted by both pixels.
+        m_perimeter -= 2 * neighbors;
+        CV_DbgAssert(m_perimeter > 0);
+    }
 
-        HashedPoint& p = points[hash];
-        if (!p.point) {
-            p.hash = hash;
-            p.point = new Point(x, y);
-        }
+    Perimeter::Perimeter(const ConnectedComponentP_t& pixel) :
+        Attribute(pixel), ContourAttribute(pixel)
+    {}
 
-        return &p;
+    int Perimeter::compute()
+    {
+        return m_perimeter;
     }
 
-    ContourAttribute::HashedPoint::HashedPoint() :
-        hash(-1), point(0)
+    bool Perimeter::lessThan(const int lambda)
+    {
+        return m_perimeter < lambda;
+    }
+
+    Compactness::Compactness(const ConnectedComponentP_t& pixel) :
+        Attribute(pixel), ContourAttribute(pixel), Area(pixel)
     {}
 
-    ContourAttribute::ContourAttribute(const ConnectedComponentP_t& pixel) :
-        Attribute(pixel), m_start(0)
+    int Compactness::compute()
     {
-        // A pixel's border consists of
-        // the eight pixels around it.
+        return static_cast<int>((static_cast<double>(m_perimeter) * m_perimeter) / m_area);
+    }
 
-        m_contour.push_back(getPoint(pixel->m_x - 1, pixel->m_y - 1));
-        m_contour.push_back(getPoint(pixel->m_x - 1, pixel->m_y));
-        m_contour.push_back(getPoint(pixel->m_x - 1, pixel->m_y + 1));
+    bool Compactness::lessThan(const int lambda)
+    {
+        return static_cast<long long>(m_perimeter) * m_perimeter < static_cast<long long>(lambda) * m_area;
+    }
 
-        m_contour.push_back(getPoint(pixel->m_x, pixel->m_y + 1));
+    void Compactness::merge(const Ptr<Attribute>& other)
+    {
+        ContourAttribute::merge(other);
+        Area::merge(other);
+    }
 
-        m_contour.push_back(getPoint(pixel->m_x + 1, pixel->m_y + 1));
-        m_contour.push_back(getPoint(pixel->m_x + 1, pixel->m_y));
-        m_contour.push_back(getPoint(pixel->m_x + 1, pixel->m_y - 1));
+    Circularity::Circularity(const ConnectedComponentP_t& pixel) :
+        Attribute(pixel), ContourAttribute(pixel), Area(pixel)
+    {}
 
-        m_contour.push_back(getPoint(pixel->m_x , pixel->m_y - 1));
+    int Circularity::compute()
+    {
+        const double circularity = 4 * M_PI * m_area / (static_cast<double>(m_perimeter) * m_perimeter);
+        return static_cast<int>(std::min(circularity, 1.0) * 100);
+    }
 
-        m_start = m_contour.front();
+    bool Circularity::lessThan(const int lambda)
+    {
+        return lambda > 100 || 400 * M_PI * m_area < static_cast<double>(lambda) * m_perimeter * m_perimeter;
+    }
 
-        updateMap();
+    void Circularity::merge(const Ptr<Attribute>& other)
+    {
+        ContourAttribute::merge(other);
+        Area::merge(other);
     }
 
-    void ContourAttribute::updateMap()
+    MomentAttribute::MomentAttribute(const ConnectedComponentP_t& pixel) :
+        Attribute(pixel), m00(1), m10(pixel->m_x), m01(pixel->m_y),
+        m20(static_cast<long long>(pixel->m_x) * pixel->m_x),
+        m02(static_cast<long long>(pixel->m_y) * pixel->m_y),
+        m11(static_cast<long long>(pixel->m_x) * pixel->m_y)
+    {}
+
+    void MomentAttribute::merge(const Ptr<Attribute>& other)
     {
-        m_contour_map.clear();
-        for (int i = 0; i < m_contour.size(); i++) {
-            m_contour_map[m_contour[i]->hash] = i;
-        }
+        const Ptr<MomentAttribute> m_other = static_cast<Ptr<MomentAttribute> >(other);
+        m00 += m_other->m00;
+        m10 += m_other->m10;
+        m01 += m_other->m01;
+        m20 += m_other->m20;
+        m02 += m_other->m02;
+        m11 += m_other->m11;
     }
 
-    void ContourAttribute::merge(const Ptr<Attribute>& other)
+    void MomentAttribute::computeCentralMoments(double& mu20, double& mu02, double& mu11) const
     {
-        const Ptr<ContourAttribute> ca_other = static_cast<Ptr<ContourAttribute> >(other);
+        const double x = static_cast<double>(m10) / m00;
+        const double y = static_cast<double>(m01) / m00;
+
+        // A unit square has a second moment of 1/12
+        // about its center along each axis.
+        mu20 = m20 - x * m10 + m00 / 12.0;
+        mu02 = m02 - y * m01 + m00 / 12.0;
+        mu11 = m11 - x * m01;
+    }
+
+    void MomentAttribute::computeAxes(double& major, double& minor) const
+    {
+        double mu20, mu02, mu11;
+        computeCentralMoments(mu20, mu02, mu11);
+
+        const double mean = (mu20 + mu02) / 2;
+        const double deviation = sqrt((mu20 - mu02) * (mu20 - mu02) / 4 + mu11 * mu11);
+        major = mean + deviation;
+        minor = max(mean - deviation, 0.0);
+    }
+
+    Elongation::Elongation(const ConnectedComponentP_t& pixel) :
+        Attribute(pixel), MomentAttribute(pixel)
+    {}
+
+    int Elongation::compute()
+    {
+        double major, minor;
+        computeAxes(major, minor);
+        return static_cast<int>((1 - sqrt(minor / major)) * 100);
+    }
+
+    MomentOfInertia::MomentOfInertia(const ConnectedComponentP_t& pixel) :
+        Attribute(pixel), MomentAttribute(pixel)
+    {}
+
+    int MomentOfInertia::compute()
+    {
+        double mu20, mu02, mu11;
+        computeCentralMoments(mu20, mu02, mu11);
 
-        // Determine active and inactive contours.
-        vector<HashedPoint*> active = m_contour;
-        map<int, int> active_map = m_contour_map;
-
-        vector<HashedPoint*> inactive = ca_other->m_contour;
-        map<int, int> inactive_map = ca_other->m_contour_map;
-
-        // Swap, if other's start point is
-        // closer to (0, 0). By doing so, we
-        // avoid starting inside a contour.
-        if (ca_other->m_start->point->ddot(*ca_other->m_start->point) < m_start->point->ddot(*m_start->point)) {
-            active.swap(inactive);
-            active_map.swap(inactive_map);
-            m_start = ca_other->m_start;
-        }
-
-        // FIXME: Remove these.
-        CV_Assert(!active.empty());
-        CV_Assert(!inactive.empty());
-
-        // Target contour list.
-        vector<HashedPoint*> contour;
-
-        int p = 0;
-        do {
-            HashedPoint* current = active[p];
-            map<int, int>::iterator q = inactive_map.find(current->hash);
-            if (q != inactive_map.end()) {
-                // We found a neighbor, so we swap
-                // to continue running on the
-                // other contour.
-                p = q->second;
-                active.swap(inactive);
-                active_map.swap(inactive_map);
-            } else {
-                contour.push_back(current);
-            }
-            p = (p + 1) % active.size();
-        } while (active[p] != m_start);
-
-        m_contour = contour;
-        updateMap();
+        // A disc has the smallest moment of inertia, 1 / (2 pi).
+        const double inertia = (mu20 + mu02) / (static_cast<double>(m00) * m00);
+        return static_cast<int>(inertia * 2 * M_PI * 100 + 0.5);
     }
 
+    Orientation::Orientation(const ConnectedComponentP_t& pixel) :
+        Attribute(pixel), MomentAttribute(pixel)
+    {}
+
+    int Orientation::compute()
+    {
+        double mu20, mu02, mu11;
+        computeCentralMoments(mu20, mu02, mu11);
+
+        const double angle = 0.5 * atan2(2 * mu11, mu20 - mu02) * 180 / M_PI;
+        return (static_cast<int>(floor(angle + 0.5)) + 180) % 180;
+    }
+
+    Eccentricity::Eccentricity(const ConnectedComponentP_t& pixel) :
+        Attribute(pixel), MomentAttribute(pixel)
+    {}
+
+    int Eccentricity::compute()
+    {
+        double major, minor;
+        computeAxes(major, minor);
+        return static_cast<int>(sqrt(1 - minor / major) * 100);
+    }
 }
@@ -0,0 +1,214 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/Batch.h>
+
+#include <deque>
+#include <exception>
+#include <map>
+
+#include <opencv2/highgui/highgui.hpp>
+
+using namespace cv;
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        typedef function<Mat(const size_t)> Job;
+
+        struct Completion
+        {
+            size_t index;
+            Mat result;
+            exception_ptr error;
+        };
+
+        /**
+         * Runs count jobs on the pool and hands their results to
+         * callback on the calling thread. Keeps at most two jobs
+         * per worker in flight, and always waits for all started
+         * jobs, since they refer to this stack frame.
+         */
+        void run(const size_t count, const Job& job, const BatchCallback& callback,
+                 const BatchOrder order, ThreadPool& pool)
+        {
+            mutex completed_mutex;
+            condition_variable completed_available;
+            deque<Completion> completed;
+
+            const size_t limit = 2 * pool.size();
+            size_t submitted = 0;
+            size_t received = 0;
+            size_t next = 0;
+            map<size_t, Mat> pending;
+            exception_ptr error;
+
+            while (received < submitted || (submitted < count && !error)) {
+                while (submitted < count && submitted - received < limit && !error) {
+                    const size_t index = submitted++;
+                    pool.submit([&, index]() {
+                        Completion c;
+                        c.index = index;
+                        try {
+                            c.result = job(index);
+                        } catch (...) {
+                            c.error = current_exception();
+                        }
+
+                        // Notify under the lock, as the caller may
+                        // return and destroy the condition variable
+                        // as soon as it sees the last completion.
+                        lock_guard<mutex> lock(completed_mutex);
+                        completed.push_back(c);
+                        completed_available.notify_one();
+                    });
+                }
+
+                Completion c;
+                {
+                    unique_lock<mutex> lock(completed_mutex);
+                    while (completed.empty()) {
+                        completed_available.wait(lock);
+                    }
+                    c = completed.front();
+                    completed.pop_front();
+                }
+                received++;
+
+                if (error) {
+                    continue;
+                } else if (c.error) {
+                    error = c.error;
+                    continue;
+                }
+
+                try {
+                    if (order == BATCH_AS_COMPLETED) {
+                        callback(c.index, c.result);
+                    } else {
+                        // Hold back results until all
+                        // earlier ones are passed on.
+                        pending[c.index] = c.result;
+                        for (map<size_t, Mat>::iterator it = pending.begin();
+                             it != pending.end() && it->first == next; it = pending.begin()) {
+                            callback(next++, it->second);
+                            pending.erase(it);
+                        }
+                    }
+                } catch (...) {
+                    error = current_exception();
+                }
+            }
+
+            if (error) {
+                rethrow_exception(error);
+            }
+        }
+
+        /**
+         * Buffers of results that were passed on, to be
+         * reused for the next images of a batch.
+         */
+        class Buffers
+        {
+        public:
+            Mat acquire()
+            {
+                lock_guard<mutex> lock(m_mutex);
+                if (m_free.empty()) {
+                    return Mat();
+                }
+                Mat buffer = m_free.back();
+                m_free.pop_back();
+                return buffer;
+            }
+
+            void release(const Mat& buffer)
+            {
+                lock_guard<mutex> lock(m_mutex);
+                m_free.push_back(buffer);
+            }
+
+        private:
+            mutex m_mutex;
+            vector<Mat> m_free;
+        };
+    } // namespace
+
+    vector<Mat> processBatch(const vector<Mat>& images, const ImageOperation& operation, ThreadPool& pool)
+    {
+        // The results are returned, so there
+        // are no buffers to recycle.
+        vector<Mat> results(images.size());
+        run(images.size(), [&images, &operation](const size_t index) {
+            Mat result = images[index].clone();
+            operation.apply(result);
+            return result;
+        }, [&results](const size_t index, const Mat& result) {
+            results[index] = result;
+        }, BATCH_AS_COMPLETED, pool);
+        return results;
+    }
+
+    void processBatch(const vector<Mat>& images, const ImageOperation& operation,
+                      const BatchCallback& callback, const BatchOrder order, ThreadPool& pool)
+    {
+        // Images are copied into the buffers of results that
+        // were passed on already. copyTo() keeps the memory of
+        // a buffer if the image has its size and type.
+        Buffers buffers;
+        run(images.size(), [&images, &operation, &buffers](const size_t index) {
+            Mat result = buffers.acquire();
+            images[index].copyTo(result);
+            operation.apply(result);
+            return result;
+        }, [&callback, &buffers](const size_t index, const Mat& result) {
+            callback(index, result);
+            buffers.release(result);
+        }, order, pool);
+    }
+
+    vector<bool> processFiles(const vector<string>& inputs, const vector<string>& outputs,
+                              const ImageOperation& operation, ThreadPool& pool)
+    {
+        CV_Assert(inputs.size() == outputs.size());
+
+        // Images are filtered in the buffer they are
+        // decoded into and released after encoding. Workers
+        // write to distinct bytes, unlike vector<bool> bits.
+        vector<uchar> written(inputs.size(), 0);
+        run(inputs.size(), [&](const size_t index) {
+            Mat image = imread(inputs[index], CV_LOAD_IMAGE_GRAYSCALE);
+            if (image.data) {
+                operation.apply(image);
+                written[index] = imwrite(outputs[index], image);
+            }
+            return Mat();
+        }, [](const size_t, const Mat&) {}, BATCH_AS_COMPLETED, pool);
+
+        return vector<bool>(written.begin(), written.end());
+    }
+}
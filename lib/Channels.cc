@@ -0,0 +1,178 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/Channels.h>
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        typedef unsigned int Colour;
+
+        /**
+         * Runs operation on every index in [0, count) in parallel
+         * and rethrows the first exception once all are done.
+         * Exceptions must not leave an OpenMP region.
+         */
+        void parallelFor(const int count, const function<void(const int)>& operation)
+        {
+            vector<exception_ptr> errors(count);
+#pragma omp parallel for schedule(dynamic, 1)
+            for (int i = 0; i < count; i++) {
+                try {
+                    operation(i);
+                } catch (...) {
+                    errors[i] = current_exception();
+                }
+            }
+
+            for (int i = 0; i < count; i++) {
+                if (errors[i]) {
+                    rethrow_exception(errors[i]);
+                }
+            }
+        }
+
+        /**
+         * Packs a pixel into an integer that compares like the
+         * pixel in lexicographic order.
+         */
+        inline Colour pack(const uchar* p, const int cn)
+        {
+            Colour colour = 0;
+            for (int c = 0; c < cn; c++) {
+                colour = (colour << 8) | p[c];
+            }
+            return colour;
+        }
+
+        inline void unpack(Colour colour, uchar* p, const int cn)
+        {
+            for (int c = cn - 1; c >= 0; c--) {
+                p[c] = static_cast<uchar>(colour & 0xff);
+                colour >>= 8;
+            }
+        }
+    } // namespace
+
+    Mat processChannels(const Mat& src, const ChannelOperation& operation)
+    {
+        if (src.channels() == 1) {
+            return operation(src);
+        }
+
+        vector<Mat> channels;
+        split(src, channels);
+        parallelFor(static_cast<int>(channels.size()), [&](const int c) {
+            channels[c] = operation(channels[c]);
+        });
+
+        Mat dst;
+        merge(channels, dst);
+        return dst;
+    }
+
+    Mat processChannels(const Mat& a, const Mat& b, const ChannelPairOperation& operation)
+    {
+        CV_Assert(a.channels() == b.channels());
+        if (a.channels() == 1) {
+            return operation(a, b);
+        }
+
+        vector<Mat> channels_a, channels_b;
+        split(a, channels_a);
+        split(b, channels_b);
+        parallelFor(static_cast<int>(channels_a.size()), [&](const int c) {
+            channels_a[c] = operation(channels_a[c], channels_b[c]);
+        });
+
+        Mat dst;
+        merge(channels_a, dst);
+        return dst;
+    }
+
+    Mat lexicographicRanks(const Mat& src, Mat& palette)
+    {
+        CV_Assert(src.depth() == CV_8U && src.channels() <= 4);
+
+        const int cn = src.channels();
+        vector<Colour> colours;
+        colours.reserve(src.total());
+        for (int y = 0; y < src.rows; y++) {
+            const uchar* p = src.ptr<uchar>(y);
+            for (int x = 0; x < src.cols; x++, p += cn) {
+                colours.push_back(pack(p, cn));
+            }
+        }
+
+        vector<Colour> sorted = colours;
+        sort(sorted.begin(), sorted.end());
+        sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+
+        // Ranks beyond 2^24 are not exact in single precision.
+        CV_Assert(sorted.size() <= (1u << 24));
+
+        Mat ranks(src.size(), CV_32F);
+        vector<Colour>::const_iterator colour = colours.begin();
+        for (int y = 0; y < src.rows; y++) {
+            float* r = ranks.ptr<float>(y);
+            for (int x = 0; x < src.cols; x++, colour++) {
+                r[x] = static_cast<float>(lower_bound(sorted.begin(), sorted.end(), *colour) - sorted.begin());
+            }
+        }
+
+        palette.create(1, static_cast<int>(sorted.size()), src.type());
+        uchar* p = palette.ptr<uchar>();
+        for (size_t i = 0; i < sorted.size(); i++, p += cn) {
+            unpack(sorted[i], p, cn);
+        }
+        return ranks;
+    }
+
+    Mat fromLexicographicRanks(const Mat& ranks, const Mat& palette)
+    {
+        CV_Assert(ranks.type() == CV_32F && palette.rows == 1);
+
+        const int cn = palette.channels();
+        const uchar* colours = palette.ptr<uchar>();
+        Mat dst(ranks.size(), palette.type());
+        for (int y = 0; y < ranks.rows; y++) {
+            const float* r = ranks.ptr<float>(y);
+            uchar* p = dst.ptr<uchar>(y);
+            for (int x = 0; x < ranks.cols; x++, p += cn) {
+                const int rank = static_cast<int>(r[x]);
+                CV_DbgAssert(rank >= 0 && rank < palette.cols);
+                std::copy(colours + rank * cn, colours + (rank + 1) * cn, p);
+            }
+        }
+        return dst;
+    }
+}
@@ -0,0 +1,389 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/ComponentTree.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <morphology/Utils.h>
+
+using namespace cv;
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        template <typename T>
+        vector<double> readLevels(const Mat& img)
+        {
+            const T* values = img.ptr<T>();
+            return vector<double>(values, values + img.rows * img.cols);
+        }
+
+        template <typename T>
+        Mat writeLevels(const vector<double>& levels, const int rows, const int cols, const int type)
+        {
+            Mat dst(rows, cols, type);
+            T* values = dst.ptr<T>();
+            for (size_t p = 0; p < levels.size(); p++) {
+                values[p] = saturate_cast<T>(levels[p]);
+            }
+            return dst;
+        }
+
+        vector<double> levelsOf(const Mat& img)
+        {
+            switch (img.depth()) {
+            case CV_8U:
+                return readLevels<uchar>(img);
+            case CV_16U:
+                return readLevels<ushort>(img);
+            default:
+                return readLevels<float>(img);
+            }
+        }
+
+        Mat toImage(const vector<double>& levels, const Mat& img)
+        {
+            switch (img.depth()) {
+            case CV_8U:
+                return writeLevels<uchar>(levels, img.rows, img.cols, img.type());
+            case CV_16U:
+                return writeLevels<ushort>(levels, img.rows, img.cols, img.type());
+            default:
+                return writeLevels<float>(levels, img.rows, img.cols, img.type());
+            }
+        }
+
+        /**
+         * Chooses the nodes to keep with the Viterbi algorithm,
+         * restricted to pruning: a removed node takes all of its
+         * descendants with it. Keeping a node that fails the
+         * criterion or removing one that satisfies it costs the
+         * number of pixels of the node. The costs of keeping or
+         * removing each subtree are summed up bottom-up, then the
+         * cheapest decisions are taken top-down.
+         */
+        void viterbi(const ComponentTree& tree, const vector<uchar>& satisfies, vector<uchar>& keep)
+        {
+            const vector<int>& parent = tree.tree().parent();
+            const vector<int>& order = tree.tree().order();
+
+            vector<long long> cost_keep(order.size(), 0);
+            vector<long long> cost_remove(order.size(), 0);
+
+            for (vector<int>::const_iterator it = order.begin(); it != order.end(); it++) {
+                const int n = tree.node(*it);
+                if (satisfies[n]) {
+                    cost_remove[n]++;
+                } else {
+                    cost_keep[n]++;
+                }
+
+                const int q = parent[n];
+                if (n == *it && q != n) {
+                    cost_keep[q] += min(cost_keep[n], cost_remove[n]);
+                    cost_remove[q] += cost_remove[n];
+                }
+            }
+
+            for (vector<int>::const_reverse_iterator it = order.rbegin(); it != order.rend(); it++) {
+                const int n = *it;
+                if (n == parent[n]) {
+                    keep[n] = 1;
+                } else if (tree.tree().isCanonical(n)) {
+                    keep[n] = keep[parent[n]] && cost_keep[n] <= cost_remove[n];
+                }
+            }
+        }
+
+        /**
+         * Filters tree for all lambdas with the direct rule in one
+         * top-down traversal. The values of each pixel are stored
+         * next to each other, so each node reads the values of its
+         * parent from a single location.
+         */
+        template <typename T>
+        void computeProfile(const ComponentTree& tree, const vector<int>& lambdas, Mat& filtered, Mat* differential)
+        {
+            const vector<int>& parent = tree.tree().parent();
+            const vector<int>& order = tree.tree().order();
+            const T* levels = tree.tree().image().ptr<T>();
+            const int root = tree.tree().root();
+            const int n_lambdas = static_cast<int>(lambdas.size());
+
+            T* values = filtered.ptr<T>();
+            T* differences = differential ? differential->ptr<T>() : 0;
+
+            for (vector<int>::const_reverse_iterator it = order.rbegin(); it != order.rend(); it++) {
+                const int p = *it;
+                const int n = tree.node(p);
+                T* f = values + p * n_lambdas;
+                T* d = differences ? differences + p * n_lambdas : 0;
+
+                if (p != n) {
+                    copy(values + n * n_lambdas, values + (n + 1) * n_lambdas, f);
+                    if (d) {
+                        copy(differences + n * n_lambdas, differences + (n + 1) * n_lambdas, d);
+                    }
+                    continue;
+                }
+
+                const T* f_parent = values + parent[n] * n_lambdas;
+                const int attribute = tree.attribute(n);
+                for (int k = 0; k < n_lambdas; k++) {
+                    f[k] = n == root || attribute >= lambdas[k] ? levels[n] : f_parent[k];
+                }
+
+                // Filtered levels never increase with lambda,
+                // so the differences are not negative.
+                if (d) {
+                    d[0] = levels[n] - f[0];
+                    for (int k = 1; k < n_lambdas; k++) {
+                        d[k] = f[k - 1] - f[k];
+                    }
+                }
+            }
+        }
+
+        /**
+         * Copies all channels of src to dst, starting at channel
+         * offset of dst, in reverse order if asked to.
+         */
+        void copyChannels(const Mat& src, Mat& dst, const int offset, const bool reverse)
+        {
+            const size_t size = src.elemSize1();
+            const int src_channels = src.channels();
+            const int dst_channels = dst.channels();
+            const int pixels = src.rows * src.cols;
+            const uchar* s = src.ptr();
+            uchar* d = dst.ptr();
+            for (int p = 0; p < pixels; p++) {
+                for (int k = 0; k < src_channels; k++) {
+                    const int c = offset + (reverse ? src_channels - 1 - k : k);
+                    memcpy(d + (p * dst_channels + c) * size, s + (p * src_channels + k) * size, size);
+                }
+            }
+        }
+    } // namespace
+
+    ComponentTree::ComponentTree(const Mat& img, const TreeType type) :
+        m_tree(type == MIN_TREE ? negative(img) : img), m_type(type)
+    {}
+
+    vector<double> ComponentTree::filterLevels(const int lambda, const TreeRule rule, const vector<double>& levels) const
+    {
+        const vector<int>& parent = m_tree.parent();
+        const vector<int>& order = m_tree.order();
+        const int root = m_tree.root();
+
+        vector<uchar> satisfies(order.size(), 0);
+        vector<uchar> keep(order.size(), 0);
+        for (vector<int>::const_iterator it = order.begin(); it != order.end(); it++) {
+            if (m_tree.isCanonical(*it)) {
+                satisfies[*it] = m_attributes[*it] >= lambda;
+            }
+        }
+
+        switch (rule) {
+        case RULE_MIN:
+            // The root is kept whatever its attribute, so
+            // its children only depend on their own.
+            for (vector<int>::const_reverse_iterator it = order.rbegin(); it != order.rend(); it++) {
+                const int n = *it;
+                if (m_tree.isCanonical(n)) {
+                    keep[n] = n == root || (satisfies[n] && keep[parent[n]]);
+                }
+            }
+            break;
+        case RULE_MAX:
+            // Children come before their parents.
+            for (vector<int>::const_iterator it = order.begin(); it != order.end(); it++) {
+                const int n = *it;
+                if (m_tree.isCanonical(n)) {
+                    keep[n] = keep[n] || satisfies[n];
+                    keep[parent[n]] = keep[parent[n]] || keep[n];
+                }
+            }
+            break;
+        case RULE_VITERBI:
+            viterbi(*this, satisfies, keep);
+            break;
+        default:
+            keep = satisfies;
+        }
+
+        // The root is the background and is always kept.
+        keep[root] = 1;
+
+        // Assign new levels to the nodes top-down.
+        vector<double> filtered(order.size());
+        for (vector<int>::const_reverse_iterator it = order.rbegin(); it != order.rend(); it++) {
+            const int p = *it;
+            const int n = node(p);
+            if (p != n) {
+                filtered[p] = filtered[n];
+            } else if (p == root) {
+                filtered[p] = levels[p];
+            } else if (!keep[p]) {
+                filtered[p] = filtered[parent[p]];
+            } else if (rule == RULE_SUBTRACTIVE) {
+                filtered[p] = filtered[parent[p]] + levels[p] - levels[parent[p]];
+            } else {
+                filtered[p] = levels[p];
+            }
+        }
+
+        return filtered;
+    }
+
+    Mat ComponentTree::filter(const int lambda, const TreeRule rule) const
+    {
+        const vector<double> levels = levelsOf(m_tree.image());
+        Mat dst = toImage(filterLevels(lambda, rule, levels), m_tree.image());
+        return m_type == MIN_TREE ? negative(dst) : dst;
+    }
+
+    Mat ComponentTree::residual(const int lambda, const TreeRule rule) const
+    {
+        // The tree of a min-tree is built on the negative image,
+        // so the residual needs no negation.
+        const vector<double> levels = levelsOf(m_tree.image());
+        vector<double> residual = filterLevels(lambda, rule, levels);
+        for (size_t p = 0; p < residual.size(); p++) {
+            residual[p] = levels[p] - residual[p];
+        }
+        return toImage(residual, m_tree.image());
+    }
+
+    Mat ComponentTree::residual(const int lambda_low, const int lambda_high, const TreeRule rule) const
+    {
+        CV_Assert(lambda_low <= lambda_high);
+
+        const vector<double> levels = levelsOf(m_tree.image());
+        vector<double> residual = filterLevels(lambda_low, rule, levels);
+        const vector<double> high = filterLevels(lambda_high, rule, levels);
+        for (size_t p = 0; p < residual.size(); p++) {
+            residual[p] -= high[p];
+        }
+        return toImage(residual, m_tree.image());
+    }
+
+    void ComponentTree::ultimateOpening(Mat& residual, Mat& scales, const int max_lambda) const
+    {
+        const vector<int>& parent = m_tree.parent();
+        const vector<int>& order = m_tree.order();
+        const vector<double> levels = levelsOf(m_tree.image());
+
+        // The contrast of the chain of ancestors with the same
+        // attribute as the node, and the best residual and its
+        // scale among the chains above.
+        vector<double> chain(order.size(), 0);
+        vector<double> above(order.size(), 0);
+        vector<int> above_scale(order.size(), 0);
+
+        vector<double> best(order.size());
+        vector<int> best_scale(order.size());
+
+        for (vector<int>::const_reverse_iterator it = order.rbegin(); it != order.rend(); it++) {
+            const int p = *it;
+            const int n = node(p);
+            const int q = parent[n];
+            if (p == n && q != n && m_attributes[n] < max_lambda) {
+                if (m_attributes[n] == m_attributes[q]) {
+                    chain[n] = chain[q] + levels[n] - levels[q];
+                    above[n] = above[q];
+                    above_scale[n] = above_scale[q];
+                } else {
+                    chain[n] = levels[n] - levels[q];
+                    above[n] = best[q];
+                    above_scale[n] = best_scale[q];
+                }
+            }
+
+            // Ties go to the larger scale above.
+            if (p == n) {
+                best[n] = chain[n] > above[n] ? chain[n] : above[n];
+                best_scale[n] = chain[n] > above[n] ? m_attributes[n] : above_scale[n];
+            }
+            best[p] = best[n];
+            best_scale[p] = best_scale[n];
+        }
+
+        residual = toImage(best, m_tree.image());
+        scales = Mat(m_tree.image().size(), CV_32S);
+        copy(best_scale.begin(), best_scale.end(), scales.ptr<int>());
+    }
+
+    void ComponentTree::profile(const vector<int>& lambdas, Mat& filtered, Mat* differential) const
+    {
+        CV_Assert(!lambdas.empty() && static_cast<int>(lambdas.size()) <= CV_CN_MAX);
+        for (size_t k = 1; k < lambdas.size(); k++) {
+            CV_Assert(lambdas[k - 1] <= lambdas[k]);
+        }
+
+        const Mat& img = m_tree.image();
+        const int type = CV_MAKETYPE(img.depth(), static_cast<int>(lambdas.size()));
+        filtered.create(img.rows, img.cols, type);
+        if (differential) {
+            differential->create(img.rows, img.cols, type);
+        }
+
+        switch (img.depth()) {
+        case CV_8U:
+            computeProfile<uchar>(*this, lambdas, filtered, differential);
+            break;
+        case CV_16U:
+            computeProfile<ushort>(*this, lambdas, filtered, differential);
+            break;
+        default:
+            computeProfile<float>(*this, lambdas, filtered, differential);
+        }
+
+        if (m_type == MIN_TREE) {
+            negative(filtered);
+        }
+    }
+
+    void assembleProfile(const Mat& img, const Mat& openings, const Mat& closings,
+                         const Mat& open_differences, const Mat& close_differences,
+                         Mat& profile, Mat* differential)
+    {
+        const int n = openings.channels();
+        CV_Assert(2 * n + 1 <= CV_CN_MAX && closings.channels() == n);
+
+        profile.create(img.rows, img.cols, CV_MAKETYPE(img.depth(), 2 * n + 1));
+        copyChannels(closings, profile, 0, true);
+        copyChannels(img.isContinuous() ? img : img.clone(), profile, n, false);
+        copyChannels(openings, profile, n + 1, false);
+
+        if (differential) {
+            differential->create(img.rows, img.cols, CV_MAKETYPE(img.depth(), 2 * n));
+            copyChannels(close_differences, *differential, 0, true);
+            copyChannels(open_differences, *differential, n, false);
+        }
+    }
+}
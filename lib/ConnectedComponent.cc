@@ -24,6 +24,7 @@
 
 #include <morphology/ConnectedComponent.h>
 #include <morphology/Attributes.h>
+#include <morphology/FilterStatistics.h>
 
 namespace morphology
 {
@@ -37,12 +38,15 @@ namespace morphology
         m_parent = parent;
     }
 
-    ConnectedComponentP_t ConnectedComponent::findRoot(ConnectedComponentP_t& set)
+    ConnectedComponentP_t ConnectedComponent::findRoot(ConnectedComponentP_t& set, FilterStatistics* statistics)
     {
+        size_t length = 0;
         ConnectedComponentP_t root = set;
         while (root !=root->m_parent) {
             root = root->m_parent;
+            length++;
         }
+        MORPHOLOGY_COUNT(statistics, addPathLength(length));
 
         ConnectedComponentP_t current = set;
         while(current != root) {
@@ -57,10 +61,11 @@ namespace morphology
         return root;
     }
 
-    bool ConnectedComponent::isActive(int lambda)
+    bool ConnectedComponent::isActive(int lambda, FilterStatistics* statistics)
     {
         if (m_active) {
-            m_active = m_attribute->compute() < lambda;
+            MORPHOLOGY_COUNT(statistics, compute_calls++);
+            m_active = m_attribute->lessThan(lambda);
         }
         return m_active;
     }
@@ -51,4 +51,28 @@ namespace morphology
         AttributeFilter<Area> filter;
         filter.close(input, lambda);
     }
+
+    cv::Mat areaOpen(const cv::Mat& input, const cv::Mat& lambdas)
+    {
+        AttributeFilter<Area> filter;
+        return filter.open(input, lambdas);
+    }
+
+    void areaOpen(cv::Mat& input, const cv::Mat& lambdas)
+    {
+        AttributeFilter<Area> filter;
+        filter.open(input, lambdas);
+    }
+
+    cv::Mat areaClose(const cv::Mat& input, const cv::Mat& lambdas)
+    {
+        AttributeFilter<Area> filter;
+        return filter.close(input, lambdas);
+    }
+
+    void areaClose(cv::Mat& input, const cv::Mat& lambdas)
+    {
+        AttributeFilter<Area> filter;
+        filter.close(input, lambdas);
+    }
 }
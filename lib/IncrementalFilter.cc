@@ -0,0 +1,170 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/IncrementalFilter.h>
+
+#include <cstring>
+
+#include <morphology/AttributeFilter.h>
+#include <morphology/Profiler.h>
+
+using namespace cv;
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        inline Rect grow(const Rect& r, const int margin, const Rect& bounds)
+        {
+            return Rect(r.x - margin, r.y - margin, r.width + 2 * margin, r.height + 2 * margin) & bounds;
+        }
+
+        /**
+         * @returns true if a and b differ within tile.
+         */
+        bool differ(const Mat& a, const Mat& b, const Rect& tile)
+        {
+            for (int y = tile.y; y < tile.y + tile.height; y++) {
+                if (memcmp(a.ptr(y) + tile.x, b.ptr(y) + tile.x, tile.width) != 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool anyChanged(const Mat& changed, const Rect& tile)
+        {
+            for (int y = tile.y; y < tile.y + tile.height; y++) {
+                const uchar* c = changed.ptr(y) + tile.x;
+                for (int x = 0; x < tile.width; x++) {
+                    if (c[x]) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+    } // namespace
+
+    IncrementalAreaFilter::IncrementalAreaFilter(const int lambda, const bool closing, const int tile_size) :
+        m_lambda(lambda), m_closing(closing), m_tile_size(tile_size), m_filtered_pixels(0)
+    {
+        CV_Assert(tile_size > 0);
+    }
+
+    const Mat& IncrementalAreaFilter::apply(const Mat& frame)
+    {
+        CV_Assert(frame.type() == CV_8U);
+        if (m_result.empty() || frame.size() != m_frame.size()) {
+            return filterAll(frame);
+        }
+
+        vector<Rect> tiles;
+        const Rect bounds(0, 0, frame.cols, frame.rows);
+        for (int y = 0; y < frame.rows; y += m_tile_size) {
+            for (int x = 0; x < frame.cols; x += m_tile_size) {
+                const Rect tile = Rect(x, y, m_tile_size, m_tile_size) & bounds;
+                if (differ(frame, m_frame, tile)) {
+                    tiles.push_back(tile);
+                }
+            }
+        }
+        return update(frame, tiles);
+    }
+
+    const Mat& IncrementalAreaFilter::apply(const Mat& frame, const Mat& changed)
+    {
+        CV_Assert(frame.type() == CV_8U);
+        CV_Assert(changed.type() == CV_8U && changed.size() == frame.size());
+        if (m_result.empty() || frame.size() != m_frame.size()) {
+            return filterAll(frame);
+        }
+
+        vector<Rect> tiles;
+        const Rect bounds(0, 0, frame.cols, frame.rows);
+        for (int y = 0; y < frame.rows; y += m_tile_size) {
+            for (int x = 0; x < frame.cols; x += m_tile_size) {
+                const Rect tile = Rect(x, y, m_tile_size, m_tile_size) & bounds;
+                if (anyChanged(changed, tile)) {
+                    tiles.push_back(tile);
+                }
+            }
+        }
+        return update(frame, tiles);
+    }
+
+    void IncrementalAreaFilter::reset()
+    {
+        m_frame.release();
+        m_result.release();
+    }
+
+    Mat IncrementalAreaFilter::filter(const Mat& img) const
+    {
+        AttributeFilter<Area> filter;
+        return m_closing ? filter.close(img, m_lambda) : filter.open(img, m_lambda);
+    }
+
+    const Mat& IncrementalAreaFilter::filterAll(const Mat& frame)
+    {
+        m_frame = frame.clone();
+        m_result = filter(m_frame);
+        m_filtered_pixels = static_cast<long long>(frame.rows) * frame.cols;
+        return m_result;
+    }
+
+    const Mat& IncrementalAreaFilter::update(const Mat& frame, const vector<Rect>& tiles)
+    {
+        MORPHOLOGY_PROFILE("incremental area filter");
+
+        const int margin = std::max(m_lambda - 1, 0);
+        const Rect bounds(0, 0, frame.cols, frame.rows);
+
+        // The results within margin of a tile change, and they
+        // depend on the pixels within margin of those.
+        vector<Rect> affected;
+        vector<Rect> windows;
+        long long pixels = 0;
+        for (vector<Rect>::const_iterator it = tiles.begin(); it != tiles.end(); it++) {
+            affected.push_back(grow(*it, margin, bounds));
+            windows.push_back(grow(affected.back(), margin, bounds));
+            pixels += windows.back().area();
+        }
+
+        if (2 * pixels > static_cast<long long>(frame.rows) * frame.cols) {
+            return filterAll(frame);
+        }
+
+        frame.copyTo(m_frame);
+        for (size_t i = 0; i < windows.size(); i++) {
+            const Mat filtered = filter(m_frame(windows[i]));
+            const Rect inner(affected[i].x - windows[i].x, affected[i].y - windows[i].y, affected[i].width, affected[i].height);
+            Mat result = m_result(affected[i]);
+            filtered(inner).copyTo(result);
+        }
+        m_filtered_pixels = pixels;
+        return m_result;
+    }
+}
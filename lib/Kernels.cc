@@ -0,0 +1,100 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Baseline kernels, compiled with the library's default flags
+ * (SSE2 on x86-64), and the selection of the kernel table.
+ */
+
+#define MORPHOLOGY_KERNEL_ISA generic
+#include "Kernels.inl"
+
+#include <cstdlib>
+#include <string>
+
+namespace morphology
+{
+    namespace
+    {
+        bool isSupported(const std::string& isa)
+        {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+            __builtin_cpu_init();
+            if (isa == "avx512") {
+                return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+            } else if (isa == "avx2") {
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            }
+#endif
+            return isa == "generic";
+        }
+
+        const Kernels* find(const std::string& isa)
+        {
+            if (!isSupported(isa)) {
+                return 0;
+            } else if (isa == "avx512") {
+                return avx512::kernels();
+            } else if (isa == "avx2") {
+                return avx2::kernels();
+            }
+            return generic::kernels();
+        }
+
+        const Kernels* select()
+        {
+            const char* names[] = {"avx512", "avx2", "generic"};
+
+            // Start the search at the requested instruction
+            // set, if any, and take the best one available.
+            int first = 0;
+            const char* requested = std::getenv("MORPHOLOGY_CPU");
+            for (int n = 0; requested && n < 3; n++) {
+                if (names[n] == std::string(requested)) {
+                    first = n;
+                }
+            }
+
+            for (int n = first; n < 3; n++) {
+                const Kernels* k = find(names[n]);
+                if (k) {
+                    return k;
+                }
+            }
+            return generic::kernels();
+        }
+
+        // Select the kernels when the library is loaded.
+        struct SelectOnLoad
+        {
+            SelectOnLoad() { kernels(); }
+        } select_on_load;
+    } // namespace
+
+    const Kernels& kernels()
+    {
+        static const Kernels* selected = select();
+        return *selected;
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MORPHOLOGY_KERNELS_H
+#define __MORPHOLOGY_KERNELS_H
+
+#include <opencv2/core/core.hpp>
+
+namespace morphology
+{
+    /**
+     * Row kernels of the hot loops for one pixel type. Each
+     * kernel works on contiguous pixels, so the compiler can
+     * vectorize it for whatever instruction set its translation
+     * unit is compiled for.
+     */
+    template <typename T>
+    struct PixelKernels
+    {
+        /**
+         * Dilates cols pixels of the marker row p_j with the row
+         * p_previous visited before it and clamps them to the mask
+         * row p_i. p_previous[-1] and p_previous[cols] must exist.
+         */
+        void (*dilateRow)(const T* p_i, const T* p_previous, T* p_j, const int cols);
+
+        /**
+         * Sets seeds[x] to non-zero if the marker pixel p_j[x] can
+         * still raise one of its neighbors, given by offsets, under
+         * the mask p_i.
+         */
+        void (*findSeeds)(const T* p_i, const T* p_j, const int cols, const int offsets[8], uchar* seeds);
+
+        /**
+         * Writes the negatives of cols pixels of src to dst,
+         * which may be the same row.
+         */
+        void (*negative)(const T* src, T* dst, const int cols);
+
+        /**
+         * Adds the number of occurrences of each value in values
+         * to counts. Null for floating point types.
+         */
+        void (*histogram)(const T* values, const int size, int* counts);
+    };
+
+    struct Kernels
+    {
+        const char* name;
+        PixelKernels<uchar> u8;
+        PixelKernels<ushort> u16;
+        PixelKernels<float> f32;
+    };
+
+    /**
+     * Kernel tables per instruction set. A table is null if
+     * the library was built without it.
+     */
+    namespace generic { const Kernels* kernels(); }
+    namespace avx2 { const Kernels* kernels(); }
+    namespace avx512 { const Kernels* kernels(); }
+
+    /**
+     * @returns the kernels for the best instruction set that both
+     * the library and the CPU support. The choice is made once,
+     * when the library is loaded. For testing, the environment
+     * variable MORPHOLOGY_CPU=generic|avx2|avx512 selects a lower
+     * instruction set.
+     */
+    const Kernels& kernels();
+
+    template <typename T>
+    const PixelKernels<T>& pixelKernels();
+
+    template <>
+    inline const PixelKernels<uchar>& pixelKernels<uchar>()
+    {
+        return kernels().u8;
+    }
+
+    template <>
+    inline const PixelKernels<ushort>& pixelKernels<ushort>()
+    {
+        return kernels().u16;
+    }
+
+    template <>
+    inline const PixelKernels<float>& pixelKernels<float>()
+    {
+        return kernels().f32;
+    }
+}
+
+#endif // __MORPHOLOGY_KERNELS_H
@@ -0,0 +1,159 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Implementation of the kernels declared in Kernels.h. Every
+ * translation unit that includes this file compiles the kernels
+ * into the namespace MORPHOLOGY_KERNEL_ISA with its own compiler
+ * flags.
+ */
+
+#ifndef MORPHOLOGY_KERNEL_ISA
+  #error "Define MORPHOLOGY_KERNEL_ISA before including Kernels.inl"
+#endif
+
+#include <cstring>
+
+#include "Kernels.h"
+
+#define MORPHOLOGY_STRINGIFY_(x) #x
+#define MORPHOLOGY_STRINGIFY(x) MORPHOLOGY_STRINGIFY_(x)
+
+namespace morphology
+{
+    namespace MORPHOLOGY_KERNEL_ISA
+    {
+        namespace
+        {
+            // Inline functions of the standard library are
+            // shared between translation units, so the linker
+            // could pick a copy compiled for another instruction
+            // set. Kernels use these local helpers instead.
+            template <typename T>
+            inline T maximum(const T a, const T b) { return a < b ? b : a; }
+
+            template <typename T>
+            inline T minimum(const T a, const T b) { return b < a ? b : a; }
+
+            template <typename T>
+            void dilateRow(const T* p_i, const T* p_previous, T* p_j, const int cols)
+            {
+                for (int x = 0; x < cols; x++) {
+                    const T previous = maximum(maximum(p_previous[x - 1], p_previous[x]), p_previous[x + 1]);
+                    p_j[x] = minimum(maximum(previous, p_j[x]), p_i[x]);
+                }
+            }
+
+            template <typename T>
+            void findSeeds(const T* p_i, const T* p_j, const int cols, const int offsets[8], uchar* seeds)
+            {
+                // Copy the offsets, so that the compiler
+                // knows they do not alias the rows.
+                int o[8];
+                for (int n = 0; n < 8; n++) {
+                    o[n] = offsets[n];
+                }
+
+                for (int x = 0; x < cols; x++) {
+                    bool seed = false;
+                    for (int n = 0; n < 8; n++) {
+                        const T q_j = p_j[x + o[n]];
+                        seed |= q_j < p_j[x] && q_j < p_i[x + o[n]];
+                    }
+                    seeds[x] = seed;
+                }
+            }
+
+            inline uchar negate(const uchar v) { return 255 - v; }
+            inline ushort negate(const ushort v) { return 65535 - v; }
+            inline float negate(const float v) { return -v; }
+
+            template <typename T>
+            void negative(const T* src, T* dst, const int cols)
+            {
+                for (int x = 0; x < cols; x++) {
+                    dst[x] = negate(src[x]);
+                }
+            }
+
+            template <typename T>
+            void histogram(const T* values, const int size, int* counts)
+            {
+                for (int p = 0; p < size; p++) {
+                    counts[values[p]]++;
+                }
+            }
+
+            // Four interleaved tables hide the latency of
+            // incrementing the same bin repeatedly, which is
+            // common in images with large flat zones.
+            void histogram(const uchar* values, const int size, int* counts)
+            {
+                int partial[4][256];
+                std::memset(partial, 0, sizeof(partial));
+
+                int p = 0;
+                for (; p + 4 <= size; p += 4) {
+                    partial[0][values[p]]++;
+                    partial[1][values[p + 1]]++;
+                    partial[2][values[p + 2]]++;
+                    partial[3][values[p + 3]]++;
+                }
+                for (; p < size; p++) {
+                    partial[0][values[p]]++;
+                }
+                for (int v = 0; v < 256; v++) {
+                    counts[v] += partial[0][v] + partial[1][v] + partial[2][v] + partial[3][v];
+                }
+            }
+
+            template <typename T>
+            PixelKernels<T> makePixelKernels(void (*histogram)(const T*, const int, int*))
+            {
+                PixelKernels<T> k;
+                k.dilateRow = dilateRow<T>;
+                k.findSeeds = findSeeds<T>;
+                k.negative = negative<T>;
+                k.histogram = histogram;
+                return k;
+            }
+
+            Kernels makeKernels()
+            {
+                Kernels k;
+                k.name = MORPHOLOGY_STRINGIFY(MORPHOLOGY_KERNEL_ISA);
+                k.u8 = makePixelKernels<uchar>(histogram);
+                k.u16 = makePixelKernels<ushort>(histogram<ushort>);
+                k.f32 = makePixelKernels<float>(0);
+                return k;
+            }
+        } // namespace
+
+        const Kernels* kernels()
+        {
+            static const Kernels table = makeKernels();
+            return &table;
+        }
+    }
+}
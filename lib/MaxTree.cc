@@ -0,0 +1,197 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/MaxTree.h>
+
+#include <algorithm>
+
+#include "Kernels.h"
+#include "UnionFind.h"
+
+using namespace cv;
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        /**
+         * Orders pixel indices by decreasing grey value and
+         * by scan-line order among pixels of equal value.
+         */
+        template <typename T>
+        struct DecreasingValue
+        {
+            const T* values;
+
+            DecreasingValue(const T* _values) : values(_values) {}
+
+            bool operator()(const int l, const int r) const
+            {
+                return values[l] > values[r] || (values[l] == values[r] && l < r);
+            }
+        };
+
+        /**
+         * Sorts pixels with a stable counting sort. Only used
+         * for integer depths with a small value range.
+         */
+        template <typename T>
+        vector<int> countingSort(const T* values, const int size, const int range)
+        {
+            vector<int> counts(range, 0);
+            pixelKernels<T>().histogram(values, size, &counts[0]);
+
+            // Values are sorted in decreasing order, so the
+            // offset of each value follows the higher ones.
+            vector<int> offsets(range + 1, 0);
+            for (int k = 1; k <= range; k++) {
+                offsets[k] = offsets[k - 1] + counts[range - k];
+            }
+
+            vector<int> order(size);
+            for (int p = 0; p < size; p++) {
+                order[offsets[range - 1 - values[p]]++] = p;
+            }
+            return order;
+        }
+
+        template <typename T>
+        vector<int> sortPixels(const T* values, const int size)
+        {
+            vector<int> order(size);
+            for (int p = 0; p < size; p++) {
+                order[p] = p;
+            }
+            sort(order.begin(), order.end(), DecreasingValue<T>(values));
+            return order;
+        }
+
+        template <>
+        vector<int> sortPixels<uchar>(const uchar* values, const int size)
+        {
+            return countingSort(values, size, 1 << 8);
+        }
+
+        template <>
+        vector<int> sortPixels<ushort>(const ushort* values, const int size)
+        {
+            return countingSort(values, size, 1 << 16);
+        }
+
+        template <typename T>
+        void buildTree(const Mat& img, vector<int>& parent, vector<int>& order)
+        {
+            const T* values = img.ptr<T>();
+            const int size = img.rows * img.cols;
+
+            order = sortPixels(values, size);
+
+            // Unprocessed pixels have no parent.
+            parent.assign(size, -1);
+            vector<int> zpar(size);
+
+            for (vector<int>::const_iterator it = order.begin(); it != order.end(); it++) {
+                const int p = *it;
+                parent[p] = p;
+                zpar[p] = p;
+
+                const int x = p % img.cols;
+                const int y = p / img.cols;
+
+                // Compute pixel coordinate limits.
+                const int x_lower = std::max(x - 1, 0);
+                const int x_upper = std::min(x + 1, img.cols - 1);
+                const int y_lower = std::max(y - 1, 0);
+                const int y_upper = std::min(y + 1, img.rows - 1);
+
+                // For each processed neighbor...
+                for (int v = y_lower; v <= y_upper; v++) {
+                    for (int u = x_lower; u <= x_upper; u++) {
+                        const int n = u + v * img.cols;
+                        if (parent[n] < 0) {
+                            continue;
+                        }
+
+                        const int root = findRoot(zpar, n);
+                        if (root != p) {
+                            parent[root] = p;
+                            zpar[root] = p;
+                        }
+                    }
+                }
+            }
+
+            // Let each pixel point to the canonical
+            // pixel of its node, starting at the root.
+            for (vector<int>::const_reverse_iterator it = order.rbegin(); it != order.rend(); it++) {
+                const int p = *it;
+                const int q = parent[p];
+                if (values[parent[q]] == values[q]) {
+                    parent[p] = parent[q];
+                }
+            }
+        }
+    } // namespace
+
+    MaxTree::MaxTree(const Mat& img)
+    {
+        CV_Assert(img.channels() == 1 && !img.empty());
+
+        // Pixels are addressed by linear indices.
+        m_image = img.isContinuous() ? img : img.clone();
+
+        switch (m_image.depth()) {
+        case CV_8U:
+            buildTree<uchar>(m_image, m_parent, m_order);
+            break;
+        case CV_16U:
+            buildTree<ushort>(m_image, m_parent, m_order);
+            break;
+        case CV_32F:
+            buildTree<float>(m_image, m_parent, m_order);
+            break;
+        default:
+            CV_Error(CV_StsUnsupportedFormat, "MaxTree supports CV_8U, CV_16U and CV_32F images only");
+        }
+    }
+
+    bool MaxTree::isCanonical(const int p) const
+    {
+        const int q = m_parent[p];
+        if (p == q) {
+            return true;
+        }
+
+        const int cols = m_image.cols;
+        switch (m_image.depth()) {
+        case CV_8U:
+            return m_image.at<uchar>(p / cols, p % cols) != m_image.at<uchar>(q / cols, q % cols);
+        case CV_16U:
+            return m_image.at<ushort>(p / cols, p % cols) != m_image.at<ushort>(q / cols, q % cols);
+        default:
+            return m_image.at<float>(p / cols, p % cols) != m_image.at<float>(q / cols, q % cols);
+        }
+    }
+}
@@ -0,0 +1,283 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/Profiler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        typedef chrono::steady_clock Clock;
+
+        struct Event
+        {
+            const char* name;
+            int parent;
+            long long start;
+            long long end;
+        };
+
+        /**
+         * The spans of one thread. Only the owning thread
+         * writes, the lock guards against concurrent export.
+         */
+        struct ThreadBuffer
+        {
+            int tid;
+            long long generation;
+            mutex lock;
+            vector<Event> events;
+            vector<int> open;
+        };
+
+        /**
+         * Buffers are never freed, so that spans of
+         * finished threads can still be exported.
+         */
+        struct Registry
+        {
+            mutex lock;
+            vector<ThreadBuffer*> buffers;
+            set<string> names;
+            Clock::time_point epoch;
+
+            Registry() : epoch(Clock::now()) {}
+        };
+
+        Registry& registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        ThreadBuffer& threadBuffer()
+        {
+            static thread_local ThreadBuffer* buffer = 0;
+            if (!buffer) {
+                Registry& r = registry();
+                lock_guard<mutex> guard(r.lock);
+                buffer = new ThreadBuffer();
+                buffer->tid = r.buffers.size();
+                buffer->generation = 0;
+                r.buffers.push_back(buffer);
+            }
+            return *buffer;
+        }
+
+        long long now()
+        {
+            return chrono::duration_cast<chrono::nanoseconds>(Clock::now() - registry().epoch).count();
+        }
+
+        bool enabledByEnvironment()
+        {
+            const char* value = getenv("MORPHOLOGY_PROFILE");
+            return value && strcmp(value, "0") != 0;
+        }
+
+        /**
+         * Computes the path of every closed span of a buffer.
+         * Parents are always recorded before their children.
+         */
+        vector<string> computePaths(const ThreadBuffer& buffer)
+        {
+            vector<string> paths(buffer.events.size());
+            for (size_t i = 0; i < buffer.events.size(); i++) {
+                const Event& e = buffer.events[i];
+                paths[i] = e.parent < 0 ? e.name : paths[e.parent] + "/" + e.name;
+            }
+            return paths;
+        }
+
+        void writeEscaped(ostream& out, const string& s)
+        {
+            out << '"';
+            for (string::const_iterator it = s.begin(); it != s.end(); it++) {
+                if (*it == '"' || *it == '\\') {
+                    out << '\\';
+                }
+                out << *it;
+            }
+            out << '"';
+        }
+    } // namespace
+
+    atomic<bool> Profiler::s_enabled(enabledByEnvironment());
+
+    void Profiler::setEnabled(bool enabled)
+    {
+        s_enabled.store(enabled);
+    }
+
+    void Profiler::reset()
+    {
+        Registry& r = registry();
+        lock_guard<mutex> guard(r.lock);
+        for (vector<ThreadBuffer*>::iterator it = r.buffers.begin(); it != r.buffers.end(); it++) {
+            lock_guard<mutex> buffer_guard((*it)->lock);
+            (*it)->events.clear();
+            (*it)->open.clear();
+            (*it)->generation++;
+        }
+    }
+
+    const char* Profiler::intern(const string& name)
+    {
+        Registry& r = registry();
+        lock_guard<mutex> guard(r.lock);
+        return r.names.insert(name).first->c_str();
+    }
+
+    long long Profiler::begin(const char* name)
+    {
+        ThreadBuffer& buffer = threadBuffer();
+        lock_guard<mutex> guard(buffer.lock);
+
+        Event e;
+        e.name = name ? name : "";
+        e.parent = buffer.open.empty() ? -1 : buffer.open.back();
+        e.end = -1;
+
+        const int index = buffer.events.size();
+        buffer.events.push_back(e);
+        buffer.open.push_back(index);
+
+        // Take the time last to exclude the bookkeeping.
+        buffer.events.back().start = now();
+        return (buffer.generation << 32) | index;
+    }
+
+    void Profiler::end(long long id)
+    {
+        const long long time = now();
+
+        ThreadBuffer& buffer = threadBuffer();
+        lock_guard<mutex> guard(buffer.lock);
+
+        // Discard spans opened before a reset.
+        if ((id >> 32) != buffer.generation) {
+            return;
+        }
+
+        buffer.events[id & 0xffffffff].end = time;
+        buffer.open.pop_back();
+    }
+
+    vector<SpanStatistics> Profiler::statistics()
+    {
+        map<string, vector<double> > durations;
+        {
+            Registry& r = registry();
+            lock_guard<mutex> guard(r.lock);
+            for (vector<ThreadBuffer*>::iterator it = r.buffers.begin(); it != r.buffers.end(); it++) {
+                lock_guard<mutex> buffer_guard((*it)->lock);
+                const vector<string> paths = computePaths(**it);
+                for (size_t i = 0; i < paths.size(); i++) {
+                    const Event& e = (*it)->events[i];
+                    if (e.end >= 0) {
+                        durations[paths[i]].push_back((e.end - e.start) * 1e-9);
+                    }
+                }
+            }
+        }
+
+        vector<SpanStatistics> statistics;
+        for (map<string, vector<double> >::iterator it = durations.begin(); it != durations.end(); it++) {
+            vector<double>& d = it->second;
+            sort(d.begin(), d.end());
+
+            SpanStatistics s;
+            s.path = it->first;
+            s.count = d.size();
+            s.total = 0;
+            for (size_t i = 0; i < d.size(); i++) {
+                s.total += d[i];
+            }
+            s.min = d.front();
+            s.max = d.back();
+            s.mean = s.total / d.size();
+
+            // Nearest-rank percentile.
+            const size_t rank = (99 * d.size() + 99) / 100;
+            s.p99 = d[rank - 1];
+            statistics.push_back(s);
+        }
+        return statistics;
+    }
+
+    void Profiler::writeJson(ostream& out)
+    {
+        const vector<SpanStatistics> stats = statistics();
+        out << "{\"spans\": [";
+        for (size_t i = 0; i < stats.size(); i++) {
+            const SpanStatistics& s = stats[i];
+            out << (i > 0 ? ",\n  " : "\n  ") << "{\"path\": ";
+            writeEscaped(out, s.path);
+            out << ", \"count\": " << s.count
+                << ", \"total\": " << s.total
+                << ", \"min\": " << s.min
+                << ", \"mean\": " << s.mean
+                << ", \"p99\": " << s.p99
+                << ", \"max\": " << s.max << "}";
+        }
+        out << "\n]}\n";
+    }
+
+    void Profiler::writeChromeTrace(ostream& out)
+    {
+        Registry& r = registry();
+        lock_guard<mutex> guard(r.lock);
+
+        bool first = true;
+        out << "{\"traceEvents\": [";
+        for (vector<ThreadBuffer*>::iterator it = r.buffers.begin(); it != r.buffers.end(); it++) {
+            lock_guard<mutex> buffer_guard((*it)->lock);
+            for (vector<Event>::const_iterator e = (*it)->events.begin(); e != (*it)->events.end(); e++) {
+                if (e->end < 0) {
+                    continue;
+                }
+
+                // Chrome expects microseconds. Write integers, as
+                // doubles lose precision in the default format.
+                out << (first ? "\n  " : ",\n  ") << "{\"name\": ";
+                writeEscaped(out, e->name);
+                out << ", \"ph\": \"X\", \"pid\": 0, \"tid\": " << (*it)->tid
+                    << ", \"ts\": " << e->start / 1000
+                    << ", \"dur\": " << (e->end - e->start) / 1000 << "}";
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+    }
+}
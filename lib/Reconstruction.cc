@@ -27,8 +27,12 @@
 #include <queue>
 #include <omp.h>
 
+#include <morphology/Channels.h>
+#include <morphology/MaxTree.h>
 #include <morphology/Utils.h>
 
+#include "Kernels.h"
+
 using namespace cv;
 
 namespace morphology
@@ -36,255 +40,459 @@ namespace morphology
     namespace
     {
         /**
-         * Pairs a pixel with a non-const pointer to another pixel
-         * and stores their respective coordinates.
+         * Pairs a pixel of the mask with the corresponding
+         * pixel of the marker.
          */
+        template <typename T>
         struct PixelPair
         {
-            const uchar* p_i;
-            uchar* p_j;
-            cv::Point coords;
+            const T* p_i;
+            T* p_j;
 
             PixelPair () : p_i(0), p_j(0) {}
 
-            PixelPair(const uchar* _p_i, uchar* _p_j, const int _x, const int _y) :
-                p_i(_p_i), p_j(_p_j), coords(_x, _y) {}
+            PixelPair(const T* _p_i, T* _p_j) :
+                p_i(_p_i), p_j(_p_j) {}
         };
 
         /**
-         * @returns a queue of pixels representing the
-         * boundaries of the markers on image j. Keeps
-         * a one-pixel margin around the image.
+         * @returns a copy of src inside a buffer with a one-pixel
+         * border of the lowest value of T. That value is a fixed
+         * point of reconstruction by dilation: a border pixel can
+         * never be raised above its mask value, which is the lowest
+         * value as well. Hence, every image pixel has a full
+         * neighborhood and no kernel needs bounds checks.
          */
-        inline std::queue<PixelPair> initPixelQueue(const Mat& mask, Mat& marker)
+        template <typename T>
+        inline Mat pad(const Mat& src)
         {
-            std::queue<PixelPair> fifo;
-            const uchar step = marker.step[0] / marker.step[1];
-
-            for (int y = 1; y < marker.rows - 1; y++) {
-                const uchar* p_mask = mask.ptr(y) + 1;
-                uchar* p_marker = marker.ptr(y) + 1;
-                const uchar* p_marker_end = p_marker + marker.cols - 1;
-
-                int x = 1;
-                while (p_marker != p_marker_end) {
-                    // A boundary masks defined as a pixel that itself
-                    // is not zero and that has at least one neighbor
-                    // with value zero.
-                    if (*p_marker > 0 && isBoundary(p_marker, step)) {
-                        fifo.push(PixelPair(p_mask, p_marker, x, y));
+            Mat padded(src.rows + 2, src.cols + 2, src.type(), Scalar::all(lowest<T>()));
+            Mat interior = padded(Rect(1, 1, src.cols, src.rows));
+            src.copyTo(interior);
+            return padded;
+        }
+
+        /**
+         * @returns the image region of a padded buffer without
+         * copying it.
+         */
+        inline Mat crop(const Mat& padded)
+        {
+            return padded(Rect(1, 1, padded.cols - 2, padded.rows - 2));
+        }
+
+        /**
+         * Computes the pointer offsets of the eight neighbors
+         * of a pixel for a given row step.
+         */
+        inline void computeNeighborOffsets(const int step, int offsets[8])
+        {
+            offsets[0] = -step - 1;
+            offsets[1] = -step;
+            offsets[2] = -step + 1;
+            offsets[3] = -1;
+            offsets[4] = 1;
+            offsets[5] = step - 1;
+            offsets[6] = step;
+            offsets[7] = step + 1;
+        }
+
+        /**
+         * @returns a queue of all pixels of the padded marker j
+         * that can still propagate their values under the padded
+         * mask i, i.e. that have a neighbor below both their own
+         * value and the neighbor's mask value.
+         */
+        template <typename T>
+        inline std::queue<PixelPair<T> > initPixelQueue(const Mat& i, Mat& j, const int offsets[8])
+        {
+            const PixelKernels<T>& kernels = pixelKernels<T>();
+            std::queue<PixelPair<T> > fifo;
+
+            const int cols = j.cols - 2;
+            std::vector<uchar> seeds(cols);
+            for (int y = 1; y < j.rows - 1; y++) {
+                const T* p_i = i.ptr<T>(y) + 1;
+                T* p_j = j.ptr<T>(y) + 1;
+
+                kernels.findSeeds(p_i, p_j, cols, offsets, &seeds[0]);
+                for (int x = 0; x < cols; x++) {
+                    if (seeds[x]) {
+                        fifo.push(PixelPair<T>(p_i + x, p_j + x));
                     }
-                    p_mask++;
-                    p_marker++;
-                    x++;
                 }
             }
             return fifo;
         }
 
         /**
-         * @returns the maximum value of the neighborhood
-         * in given raster direction.
+         * @returns the maximum value of the eight neighbors of p.
          */
-        inline uchar computeMaxNeighbor(const uchar* p, const uchar step, const int direction)
+        template <typename T>
+        inline T computeMaxNeighbor(const T* p, const int offsets[8])
         {
-            const int direction_step = - direction * step;
-            uchar neighbors[] = {*(p + direction),
-                    *(p - 1 + direction_step),
-                    *(p     + direction_step),
-                    *(p + 1 + direction_step)};
-            uchar max = neighbors[0];
-            for (int i = 1; i < 4; i++) {
-                if (neighbors[i] > max) {
-                    max = neighbors[i];
-                }
+            T max = *(p + offsets[0]);
+            for (int n = 1; n < 8; n++) {
+                max = std::max(max, *(p + offsets[n]));
             }
             return max;
         }
 
-        inline uchar computeMaxNeighbor(const uchar* p, const uchar step)
+        /**
+         * Propagates values along a row in given direction,
+         * starting at p_j. This part of a raster scan is
+         * inherently sequential.
+         */
+        template <typename T>
+        inline void propagateRow(const int direction, const T* p_i, T* p_j, const int cols)
         {
-            return std::max(computeMaxNeighbor(p, step, 1), computeMaxNeighbor(p, step, -1));
+            for (int x = 0; x < cols; x++) {
+                *p_j = std::max(*p_j, std::min(*(p_j - direction), *p_i));
+                p_i += direction;
+                p_j += direction;
+            }
         }
 
+        // Rows between two checks for cancellation.
+        const int STRIP_ROWS = 64;
+
+        // Queue pops between two checks for cancellation.
+        const int FIFO_STRIDE = 1 << 16;
+
         /**
-         * Scans in given raster direction over the image,
-         * performing one reconstruction step. The function
-         * spares out the margin pixels, i.e. there is a
-         * one-pixel border around the image which is not
-         * being reconstructed.
-         *
-         * @returns the number of changes made in this scan
+         * Scans in given raster direction over the padded
+         * marker j, performing one reconstruction step
+         * under the padded mask i. Reports progress from
+         * begin to end once per strip of rows.
          */
-        inline void rasterReconstruct(const int direction, const Mat& i, Mat& j)
+        template <typename T>
+        inline void rasterReconstruct(const int direction, const Mat& i, Mat& j,
+                                      TaskControl* control = 0, const double begin = 0, const double end = 0)
         {
             CV_Assert(direction == 1 || direction == -1);
 
-            const uchar step = j.step[0] / j.step[1];
+            // Dilating a row with the row visited before it does
+            // not depend on the row itself, so this half of the
+            // scan runs in the vectorized kernel.
+            const PixelKernels<T>& kernels = pixelKernels<T>();
 
-            // Start at bottom if direction is negative
-            const int start_y = direction < 0 ? j.rows - 1 : 1;
-            const int stop_y = direction < 0 ? 1 : j.rows - 1;
+            const int cols = j.cols - 2;
+
+            // Start at bottom if direction is negative.
+            const int start_y = direction < 0 ? j.rows - 2 : 1;
+            const int stop_y = direction < 0 ? 0 : j.rows - 1;
 
             for (int y = start_y; y != stop_y; y += direction) {
-                const uchar* p_i = i.ptr(y) + 1;
-                uchar* p_j = j.ptr(y) + 1;
-                const uchar* p_j_end = p_j;
+                const int done = direction < 0 ? start_y - y : y - start_y;
+                if (done % STRIP_ROWS == 0) {
+                    checkpoint(control, begin + (end - begin) * done / (j.rows - 2));
+                }
+
+                const T* p_i = i.ptr<T>(y) + 1;
+                const T* p_previous = j.ptr<T>(y - direction) + 1;
+                T* p_j = j.ptr<T>(y) + 1;
 
-                // Determine start pointers
+                kernels.dilateRow(p_i, p_previous, p_j, cols);
                 if (direction < 0) {
-                    p_i += i.cols - 1;
-                    p_j += j.cols - 1;
-                    p_j_end += 1;
+                    propagateRow(direction, p_i + cols - 1, p_j + cols - 1, cols);
                 } else {
-                    p_j_end += j.cols - 1;
+                    propagateRow(direction, p_i, p_j, cols);
                 }
+            }
+        }
+
+        /**
+         * Propagates the values of the padded marker j under
+         * the padded mask i using a fifo-queue. The length of
+         * the propagation is unknown in advance, so progress
+         * stays where it is.
+         */
+        template <typename T>
+        inline void fifoReconstruct(const Mat& i, Mat& j, TaskControl* control = 0, const double progress = 0)
+        {
+            CV_Assert(i.step[0] == j.step[0]);
+
+            int offsets[8];
+            computeNeighborOffsets(j.step[0] / j.step[1], offsets);
+
+            std::queue<PixelPair<T> > fifo = initPixelQueue<T>(i, j, offsets);
+
+            // Iterate over fifo instead of image.
+            for (int pops = 0; !fifo.empty(); pops++) {
+                if (pops % FIFO_STRIDE == 0) {
+                    checkpoint(control, progress);
+                }
+
+                PixelPair<T> t = fifo.front();
+                fifo.pop();
+
+                // For each neighbor...
+                for (int n = 0; n < 8; n++) {
+                    const T* q_i = t.p_i + offsets[n];
+                    T* q_j = t.p_j + offsets[n];
 
-                while (p_j != p_j_end) {
-                    uchar value = std::min(std::max(computeMaxNeighbor(p_j, step, direction), *p_j), *p_i);
-                    if (value != *p_j) {
-                        *p_j = value;
+                    if (*q_j < *t.p_j && *q_i != *q_j) {
+                        *q_j = std::min(*t.p_j, *q_i);
+                        fifo.push(PixelPair<T>(q_i, q_j));
                     }
-                    p_i += direction;
-                    p_j += direction;
                 }
             }
         }
 
-    } // namespace
+        /**
+         * @returns a checksum of the image region of a padded
+         * buffer, ignoring the border. For floating point images
+         * the border would otherwise swamp all changes.
+         */
+        inline Scalar computeStability(const Mat& padded)
+        {
+            return sum(crop(padded));
+        }
 
-    Mat parallelReconstruct(const Mat& marker, const Mat& mask)
-    {
-        CV_Assert(marker.type() == CV_8U && mask.type() == CV_8U);
+        /**
+         * @returns an estimate of the progress of an iterative
+         * reconstruction that finished given iterations.
+         */
+        inline double estimateProgress(const int iterations)
+        {
+            return 1.0 - 1.0 / (iterations + 1);
+        }
 
-        // Images must be of the same size
-        CV_Assert(marker.size == mask.size);
-        CV_Assert(sum(marker)[0] < sum(mask)[0]);
+        template <typename T>
+        Mat parallel(const Mat& marker, const Mat& mask, TaskControl* control)
+        {
+            CV_Assert(sum(marker)[0] < sum(mask)[0]);
 
-        Mat j = marker.clone();
-        Mat k = Mat::zeros(marker.size(), marker.type());
+            const Mat i = pad<T>(mask);
+            Mat j = pad<T>(marker);
+            Mat k = j.clone();
 
-        const uchar step = j.step[0] / j.step[1];
+            int offsets[8];
+            computeNeighborOffsets(j.step[0] / j.step[1], offsets);
 
-        Scalar stability;
-        while (stability != sum(j)) {
-            stability = sum(j);
+            Scalar stability;
+            for (int iterations = 0; stability != computeStability(j); iterations++) {
+                checkpoint(control, estimateProgress(iterations));
+                stability = computeStability(j);
 
-            // Dilation step
+                // Dilation step
 #pragma omp for
-            for (int y = 1; y < k.rows; y++) {
-                const uchar* p_j = j.ptr(y) + 1;
-                uchar* p_k = k.ptr(y) + 1;
-                const uchar* p_k_end = p_k + k.cols - 1;
-
-                while (p_k != p_k_end) {
-                    *p_k = std::max(computeMaxNeighbor(p_j, step), *p_j);
-                    p_j++;
-                    p_k++;
+                for (int y = 1; y < k.rows - 1; y++) {
+                    const T* p_j = j.ptr<T>(y) + 1;
+                    T* p_k = k.ptr<T>(y) + 1;
+                    const T* p_k_end = p_k + k.cols - 2;
+
+                    while (p_k != p_k_end) {
+                        *p_k = std::max(computeMaxNeighbor(p_j, offsets), *p_j);
+                        p_j++;
+                        p_k++;
+                    }
                 }
-            }
 
-            // Point-wise minimum
+                // Point-wise minimum
 #pragma omp for
-            for (int y = 1; y < j.rows; y++) {
-                const uchar* p_i = mask.ptr(y) + 1;
-                uchar* p_j = j.ptr(y) + 1;
-                const uchar* p_k = k.ptr(y) + 1;
-                const uchar* p_j_end = p_j + j.cols - 1;
-
-                while (p_j != p_j_end) {
-                    *p_j = std::min(*p_i, *p_k);
-                    p_i++;
-                    p_j++;
-                    p_k++;
+                for (int y = 1; y < j.rows - 1; y++) {
+                    const T* p_i = i.ptr<T>(y) + 1;
+                    T* p_j = j.ptr<T>(y) + 1;
+                    const T* p_k = k.ptr<T>(y) + 1;
+                    const T* p_j_end = p_j + j.cols - 2;
+
+                    while (p_j != p_j_end) {
+                        *p_j = std::min(*p_i, *p_k);
+                        p_i++;
+                        p_j++;
+                        p_k++;
+                    }
                 }
             }
+            return crop(j);
         }
-        return j;
-    }
-
-    Mat sequentialReconstruct(const Mat& marker, const Mat& mask)
-    {
-        CV_Assert(marker.type() == CV_8U && mask.type() == CV_8U);
 
-        // Images must be of the same size
-        CV_Assert(marker.size == mask.size);
+        template <typename T>
+        Mat sequential(const Mat& marker, const Mat& mask, TaskControl* control)
+        {
+            const Mat i = pad<T>(mask);
+            Mat j = pad<T>(marker);
+
+            // Scan back and forth over the image
+            // until no changes made.
+            Scalar stability;
+            for (int iterations = 0; stability != computeStability(j); iterations++) {
+                stability = computeStability(j);
+                const double begin = estimateProgress(iterations);
+                const double end = estimateProgress(iterations + 1);
+                rasterReconstruct<T>(1, i, j, control, begin, (begin + end) / 2);
+                rasterReconstruct<T>(-1, i, j, control, (begin + end) / 2, end);
+            }
+            return crop(j);
+        }
 
-        Mat j = marker.clone();
+        template <typename T>
+        Mat queue(const Mat& marker, const Mat& mask, TaskControl* control)
+        {
+            const Mat i = pad<T>(mask);
+            Mat j = pad<T>(marker);
+            fifoReconstruct<T>(i, j, control);
+            return crop(j);
+        }
 
-        // Scan back and forth over the image
-        // until no changes made.
-        Scalar stability;
-        while (stability != sum(j)){
-            stability = sum(j);
-            rasterReconstruct(1, mask, j);
-            rasterReconstruct(-1, mask, j);
+        template <typename T>
+        Mat hybrid(const Mat& marker, const Mat& mask, TaskControl* control)
+        {
+            const Mat i = pad<T>(mask);
+            Mat j = pad<T>(marker);
+            rasterReconstruct<T>(1, i, j, control, 0.0, 1.0 / 3);
+            rasterReconstruct<T>(-1, i, j, control, 1.0 / 3, 2.0 / 3);
+            fifoReconstruct<T>(i, j, control, 2.0 / 3);
+            return crop(j);
         }
-        return j;
-    }
 
-    Mat queueReconstruct(const Mat& marker, const Mat& mask)
-    {
-        CV_Assert(marker.type() == CV_8U && mask.type() == CV_8U);
+        typedef Mat (*Reconstruction)(const Mat&, const Mat&, TaskControl*);
 
-        // Images must be of the same size
-        CV_Assert(marker.size == mask.size);
+        /**
+         * Checks the input images and calls the instance
+         * of a reconstruction that matches their depth.
+         * Channels are reconstructed concurrently unless
+         * concurrent is false.
+         */
+        inline Mat reconstructByDepth(const Mat& marker, const Mat& mask, TaskControl* control,
+                                      Reconstruction u8, Reconstruction u16, Reconstruction f32,
+                                      const bool concurrent = true)
+        {
+            CV_Assert(marker.type() == mask.type());
 
-        Mat k = marker.clone();
-        std::queue<PixelPair> fifo = initPixelQueue(mask, k);
+            // Images must be of the same size
+            CV_Assert(marker.size == mask.size);
 
-        // Iterate over fifo instead of image.
-        const uchar step = k.step[0] / k.step[1];
-        while (!fifo.empty()) {
-            PixelPair t = fifo.front();
-            fifo.pop();
+            if (marker.channels() > 1 && concurrent) {
+                return processChannels(marker, mask, [=](const Mat& marker_channel, const Mat& mask_channel) {
+                    return reconstructByDepth(marker_channel, mask_channel, control, u8, u16, f32);
+                });
+            }
 
-            const int x_lower = std::max(t.coords.x - 1, 0);
-            const int x_upper = std::min(t.coords.x + 1, mask.cols - 1);
-            const int y_lower = std::max(t.coords.y - 1, 0);
-            const int y_upper = std::min(t.coords.y + 1, mask.rows - 1);
+            if (marker.channels() > 1) {
+                std::vector<Mat> markers, masks;
+                split(marker, markers);
+                split(mask, masks);
+                for (size_t c = 0; c < markers.size(); c++) {
+                    markers[c] = reconstructByDepth(markers[c], masks[c], control, u8, u16, f32);
+                }
+                Mat dst;
+                merge(markers, dst);
+                return dst;
+            }
 
-            // For each neighbor...
-            for (int y = y_lower; y <= y_upper; y++) {
-                for (int x = x_lower; x <= x_upper; x++) {
+            switch (marker.depth()) {
+            case CV_8U:
+                return u8(marker, mask, control);
+            case CV_16U:
+                return u16(marker, mask, control);
+            case CV_32F:
+                return f32(marker, mask, control);
+            default:
+                CV_Error(CV_StsUnsupportedFormat, "Reconstruction supports CV_8U, CV_16U and CV_32F images only");
+            }
+            return Mat();
+        }
 
-                    const uchar* q_i = t.p_i - step + y * step - 1 + x;
-                    uchar* q_j = t.p_j - step + y * step - 1 + x;
+        /**
+         * Computes the h-domes for all given contrasts from a single
+         * max-tree. The reconstruction of f - h under f at a pixel p
+         * is the highest level t such that the component of the
+         * level set at t containing p has a peak of at least t + h.
+         * Walking from the root towards the leaves, a node either
+         * supports such a level itself or inherits the level of its
+         * parent, so each h costs one pass over the tree.
+         */
+        template <typename T>
+        std::vector<Mat> computeHDomes(const MaxTree& tree, const std::vector<double>& h)
+        {
+            const Mat& img = tree.image();
+            const T* f = img.ptr<T>();
+            const std::vector<int>& parent = tree.parent();
+            const std::vector<int>& order = tree.order();
+
+            // The peak of each node is the maximum of its subtree.
+            std::vector<T> peak(f, f + order.size());
+            for (std::vector<int>::const_iterator it = order.begin(); it != order.end(); it++) {
+                const int q = parent[*it];
+                peak[q] = std::max(peak[q], peak[*it]);
+            }
 
-                    // Don't compare pixel with itself!
-                    if (q_i == t.p_j && q_j == t.p_i) {
-                        continue;
+            std::vector<T> reconstruction(order.size());
+            std::vector<Mat> domes(h.size());
+            for (size_t k = 0; k < h.size(); k++) {
+                for (std::vector<int>::const_reverse_iterator it = order.rbegin(); it != order.rend(); it++) {
+                    const int p = *it;
+                    const int q = parent[p];
+
+                    // Saturate like the marker src - h would.
+                    const T marker = saturate_cast<T>(peak[p] - h[k]);
+                    if (p != q && (f[q] == f[p] || marker <= f[q])) {
+                        reconstruction[p] = reconstruction[q];
+                    } else {
+                        reconstruction[p] = std::min(f[p], marker);
                     }
+                }
 
-                    if (*q_j < *t.p_j && *q_i != *q_j) {
-                        *q_j = std::min(*t.p_j, *q_i);
-                        fifo.push(PixelPair(q_i, q_j,
-                                t.coords.x - 1 + static_cast<int>(x),
-                                t.coords.y - 1 + static_cast<int>(y)));
-                    }
+                domes[k].create(img.size(), img.type());
+                T* dome = domes[k].ptr<T>();
+                for (size_t p = 0; p < order.size(); p++) {
+                    dome[p] = saturate_cast<T>(f[p] - reconstruction[p]);
                 }
             }
+            return domes;
         }
-        return k;
+
+    } // namespace
+
+    Mat parallelReconstruct(const Mat& marker, const Mat& mask, TaskControl* control)
+    {
+        // The row loops of parallel bind to any enclosing OpenMP
+        // team, so its channels must not run inside one.
+        return reconstructByDepth(marker, mask, control, parallel<uchar>, parallel<ushort>, parallel<float>, false);
+    }
+
+    Mat sequentialReconstruct(const Mat& marker, const Mat& mask, TaskControl* control)
+    {
+        return reconstructByDepth(marker, mask, control, sequential<uchar>, sequential<ushort>, sequential<float>);
+    }
+
+    Mat queueReconstruct(const Mat& marker, const Mat& mask, TaskControl* control)
+    {
+        return reconstructByDepth(marker, mask, control, queue<uchar>, queue<ushort>, queue<float>);
+    }
+
+    Mat hybridReconstruct(const Mat& marker, const Mat& mask, TaskControl* control)
+    {
+        return reconstructByDepth(marker, mask, control, hybrid<uchar>, hybrid<ushort>, hybrid<float>);
+    }
+
+    Mat computeHDomes(const Mat& src, double h)
+    {
+        return src - hybridReconstruct(src - Scalar::all(h), src);
     }
 
-    Mat hybridReconstruct(const Mat& marker, const Mat& mask)
+    Mat computeHBasins(const Mat& src, double h)
     {
-        Mat k = marker.clone();
-        rasterReconstruct(1, mask, k);
-        rasterReconstruct(-1, mask, k);
-        return queueReconstruct(k, mask);
+        return computeHDomes(negative(src), h);
     }
 
-    Mat computeHDomes(const Mat& src, uchar h)
+    std::vector<Mat> computeHDomes(const Mat& src, const std::vector<double>& h)
     {
-        CV_Assert(src.type() == CV_8U);
-        return src - hybridReconstruct(src - h, src);
+        const MaxTree tree(src);
+        switch (src.depth()) {
+        case CV_8U:
+            return computeHDomes<uchar>(tree, h);
+        case CV_16U:
+            return computeHDomes<ushort>(tree, h);
+        default:
+            return computeHDomes<float>(tree, h);
+        }
     }
 
-    Mat computeHBasins(const Mat& src, uchar h)
+    std::vector<Mat> computeHBasins(const Mat& src, const std::vector<double>& h)
     {
-        CV_Assert(src.type() == CV_8U);
         return computeHDomes(negative(src), h);
     }
 }
@@ -0,0 +1,66 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/TaskControl.h>
+
+#include <algorithm>
+
+namespace morphology
+{
+    const char* OperationCancelled::what() const throw()
+    {
+        return "Operation cancelled";
+    }
+
+    TaskControl::TaskControl(const ProgressCallback& progress) :
+        m_cancelled(false), m_progress(progress), m_reported(0)
+    {}
+
+    void TaskControl::cancel()
+    {
+        m_cancelled.store(true);
+    }
+
+    bool TaskControl::isCancelled() const
+    {
+        return m_cancelled.load();
+    }
+
+    void TaskControl::checkpoint(const double progress)
+    {
+        if (isCancelled()) {
+            throw OperationCancelled();
+        }
+
+        // Iterative operations can only estimate their
+        // progress, so never report a step backwards. Threads
+        // of one operation may report concurrently.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const double reported = std::min(std::max(progress, m_reported), 1.0);
+        if (m_progress && reported > m_reported) {
+            m_progress(reported);
+        }
+        m_reported = reported;
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/ThreadPool.h>
+
+#include <algorithm>
+
+namespace morphology
+{
+    ThreadPool::ThreadPool(const int threads) :
+        m_stopping(false)
+    {
+        int count = threads;
+        if (count <= 0) {
+            count = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        }
+        for (int i = 0; i < count; i++) {
+            m_workers.push_back(std::thread(&ThreadPool::work, this));
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_available.notify_all();
+        for (size_t i = 0; i < m_workers.size(); i++) {
+            m_workers[i].join();
+        }
+    }
+
+    void ThreadPool::submit(const std::function<void()>& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push(task);
+        }
+        m_available.notify_one();
+    }
+
+    ThreadPool& ThreadPool::shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    void ThreadPool::work()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while (m_tasks.empty() && !m_stopping) {
+                    m_available.wait(lock);
+                }
+
+                // Drain the queue before stopping.
+                if (m_tasks.empty()) {
+                    return;
+                }
+                task = m_tasks.front();
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+}
@@ -24,22 +24,9 @@
 
 #include <morphology/Timer.h>
 
-#include <iostream>
-
-#include <opencv2/core/core.hpp>
-
-using namespace cv;
-using namespace std;
-
 namespace morphology
 {
-    Timer::Timer(const string& name) :
-        m_name(name), m_start(getTickCount())
+    Timer::Timer(const std::string& name) :
+        m_span(Profiler::isEnabled() ? Profiler::intern(name) : 0)
     {}
-
-    Timer::~Timer()
-    {
-        double elapsed = (getTickCount() - m_start) / getTickFrequency();
-        cout << "# Calculated " << m_name << " in " << elapsed << " secs.\n";
-    }
 }
@@ -0,0 +1,244 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/TreeOfShapes.h>
+
+#include <algorithm>
+
+#include <morphology/HierarchicalQueue.h>
+
+#include "UnionFind.h"
+
+using namespace cv;
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        /**
+         * @returns the median of the border pixels of img.
+         */
+        uchar borderMedian(const Mat& img)
+        {
+            vector<uchar> border;
+            for (int x = 0; x < img.cols; x++) {
+                border.push_back(img.at<uchar>(0, x));
+                border.push_back(img.at<uchar>(img.rows - 1, x));
+            }
+            for (int y = 1; y < img.rows - 1; y++) {
+                border.push_back(img.at<uchar>(y, 0));
+                border.push_back(img.at<uchar>(y, img.cols - 1));
+            }
+            nth_element(border.begin(), border.begin() + border.size() / 2, border.end());
+            return border[border.size() / 2];
+        }
+
+        /**
+         * Immerses the padded image u into a grid of twice its
+         * resolution. Pixels keep their value, the faces between
+         * them span the values of their adjacent pixels.
+         */
+        void immerse(const Mat& u, vector<uchar>& lower, vector<uchar>& upper)
+        {
+            const int rows = 2 * u.rows - 1;
+            const int cols = 2 * u.cols - 1;
+            lower.resize(rows * cols);
+            upper.resize(rows * cols);
+
+            for (int r = 0; r < rows; r++) {
+                for (int c = 0; c < cols; c++) {
+                    const int y = r / 2;
+                    const int x = c / 2;
+                    const int y_end = y + r % 2;
+                    const int x_end = x + c % 2;
+
+                    uchar low = u.at<uchar>(y, x);
+                    uchar high = low;
+                    for (int v = y; v <= y_end; v++) {
+                        for (int w = x; w <= x_end; w++) {
+                            low = std::min(low, u.at<uchar>(v, w));
+                            high = std::max(high, u.at<uchar>(v, w));
+                        }
+                    }
+                    lower[r * cols + c] = low;
+                    upper[r * cols + c] = high;
+                }
+            }
+        }
+    } // namespace
+
+    TreeOfShapes::TreeOfShapes(const Mat& img, TaskControl* control) :
+        m_size(img.size())
+    {
+        CV_Assert(img.type() == CV_8U && !img.empty());
+
+        Mat u(img.rows + 2, img.cols + 2, CV_8U, Scalar(borderMedian(img)));
+        Mat inner = u(Rect(1, 1, img.cols, img.rows));
+        img.copyTo(inner);
+
+        vector<uchar> lower, upper;
+        immerse(u, lower, upper);
+
+        m_cols = 2 * u.cols - 1;
+        const int rows = 2 * u.rows - 1;
+        const int size = rows * m_cols;
+        const int dx[] = {0, -1, 1, 0};
+        const int dy[] = {-1, 0, 0, 1};
+
+        // Sort the points by propagation from the border. Each
+        // point gets the value of its span that is closest to
+        // the level of the front when it is reached.
+        m_order.reserve(size);
+        m_levels.resize(size);
+        {
+            HierarchicalQueue queue(256);
+            vector<uchar> seen(size, 0);
+
+            int level = lower[0];
+            queue.push(level, 0);
+            seen[0] = 1;
+
+            while (!queue.empty()) {
+                level = queue.nearest(level);
+                const int p = queue.pop(level);
+                m_levels[p] = static_cast<uchar>(level);
+                m_order.push_back(p);
+
+                if (control && m_order.size() % m_cols == 0) {
+                    control->checkpoint(0.5 * m_order.size() / size);
+                }
+
+                const int x = p % m_cols;
+                const int y = p / m_cols;
+                for (int i = 0; i < 4; i++) {
+                    const int u_x = x + dx[i];
+                    const int u_y = y + dy[i];
+                    if (u_x < 0 || u_x >= m_cols || u_y < 0 || u_y >= rows) {
+                        continue;
+                    }
+
+                    const int n = u_x + u_y * m_cols;
+                    if (!seen[n]) {
+                        queue.push(std::min(std::max(level, static_cast<int>(lower[n])), static_cast<int>(upper[n])), n);
+                        seen[n] = 1;
+                    }
+                }
+            }
+        }
+
+        // Build the tree like a max-tree, from the
+        // last point reached to the first one.
+        m_parent.assign(size, -1);
+        vector<int> zpar(size);
+        for (vector<int>::const_reverse_iterator it = m_order.rbegin(); it != m_order.rend(); it++) {
+            const int p = *it;
+            m_parent[p] = p;
+            zpar[p] = p;
+
+            if (control && (it - m_order.rbegin()) % m_cols == 0) {
+                control->checkpoint(0.5 + 0.5 * (it - m_order.rbegin()) / size);
+            }
+
+            const int x = p % m_cols;
+            const int y = p / m_cols;
+            for (int i = 0; i < 4; i++) {
+                const int u_x = x + dx[i];
+                const int u_y = y + dy[i];
+                if (u_x < 0 || u_x >= m_cols || u_y < 0 || u_y >= rows) {
+                    continue;
+                }
+
+                const int n = u_x + u_y * m_cols;
+                if (m_parent[n] < 0) {
+                    continue;
+                }
+
+                const int root = findRoot(zpar, n);
+                if (root != p) {
+                    m_parent[root] = p;
+                    zpar[root] = p;
+                }
+            }
+        }
+
+        // Let each point point to the canonical
+        // point of its node, starting at the root.
+        for (vector<int>::const_iterator it = m_order.begin(); it != m_order.end(); it++) {
+            const int p = *it;
+            const int q = m_parent[p];
+            if (m_levels[m_parent[q]] == m_levels[q]) {
+                m_parent[p] = m_parent[q];
+            }
+        }
+    }
+
+    bool TreeOfShapes::isPixel(const int p) const
+    {
+        const int x = p % m_cols;
+        const int y = p / m_cols;
+        return x % 2 == 0 && y % 2 == 0 && x >= 2 && x <= 2 * m_size.width && y >= 2 && y <= 2 * m_size.height;
+    }
+
+    vector<int> TreeOfShapes::areas() const
+    {
+        vector<int> areas(m_parent.size(), 0);
+        for (vector<int>::const_reverse_iterator it = m_order.rbegin(); it != m_order.rend(); it++) {
+            const int p = *it;
+            if (isPixel(p)) {
+                areas[p]++;
+            }
+            if (m_parent[p] != p) {
+                areas[m_parent[p]] += areas[p];
+            }
+        }
+        return areas;
+    }
+
+    Mat TreeOfShapes::filter(const vector<int>& attributes, const int lambda) const
+    {
+        CV_Assert(attributes.size() == m_parent.size());
+
+        // Assign new levels to the nodes top-down.
+        vector<uchar> filtered(m_parent.size());
+        for (vector<int>::const_iterator it = m_order.begin(); it != m_order.end(); it++) {
+            const int p = *it;
+            const int q = m_parent[p];
+            if (p == q || (isCanonical(p) && attributes[p] >= lambda)) {
+                filtered[p] = m_levels[p];
+            } else {
+                filtered[p] = filtered[q];
+            }
+        }
+
+        Mat dst(m_size, CV_8U);
+        for (int y = 0; y < dst.rows; y++) {
+            uchar* d = dst.ptr(y);
+            for (int x = 0; x < dst.cols; x++) {
+                d[x] = filtered[point(x, y)];
+            }
+        }
+        return dst;
+    }
+}
@@ -0,0 +1,70 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/Utils.h>
+
+#include "Kernels.h"
+
+using namespace cv;
+
+namespace morphology
+{
+    namespace
+    {
+        template <typename T>
+        void negate(Mat& dst)
+        {
+            const PixelKernels<T>& kernels = pixelKernels<T>();
+            const int cols = dst.cols * dst.channels();
+            for (int y = 0; y < dst.rows; y++) {
+                T* p = dst.ptr<T>(y);
+                kernels.negative(p, p, cols);
+            }
+        }
+    } // namespace
+
+    Mat negative(const Mat& src)
+    {
+        Mat dst = src.clone();
+        return negative(dst);
+    }
+
+    Mat& negative(Mat& dst)
+    {
+        switch (dst.depth()) {
+        case CV_8U:
+            negate<uchar>(dst);
+            break;
+        case CV_16U:
+            negate<ushort>(dst);
+            break;
+        case CV_32F:
+            negate<float>(dst);
+            break;
+        default:
+            Mat(Scalar::all(0) - dst).copyTo(dst);
+        }
+        return dst;
+    }
+}
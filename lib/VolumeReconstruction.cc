@@ -0,0 +1,384 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/Reconstruction.h>
+
+#include <queue>
+#include <omp.h>
+
+#include <morphology/Utils.h>
+
+using namespace cv;
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        /**
+         * Describes a volume stored plane by plane in a single
+         * buffer with a one-voxel border of sentinels on every
+         * side, including one sentinel plane before and after
+         * the stack.
+         */
+        struct VolumeGeometry
+        {
+            int depth;
+            int rows;
+            int cols;
+            int step;
+            int plane;
+
+            VolumeGeometry(const int _depth, const int _rows, const int _cols) :
+                depth(_depth), rows(_rows), cols(_cols), step(_cols + 2), plane((_rows + 2) * (_cols + 2)) {}
+
+            /**
+             * @returns the buffer index of voxel (x, y, z).
+             */
+            int index(const int x, const int y, const int z) const
+            {
+                return (z + 1) * plane + (y + 1) * step + x + 1;
+            }
+        };
+
+        /**
+         * Pointer offsets of the neighbors of a voxel. The forward
+         * offsets are the neighbors that a forward raster scan
+         * visits before the voxel itself, those within the same
+         * plane first. The backward scan uses their negation.
+         */
+        struct VolumeNeighborhood
+        {
+            vector<int> forward;
+            vector<int> all;
+            size_t in_plane;
+
+            VolumeNeighborhood(const int connectivity, const VolumeGeometry& g)
+            {
+                CV_Assert(connectivity == 6 || connectivity == 26);
+
+                forward.push_back(-1);
+                if (connectivity == 6) {
+                    forward.push_back(-g.step);
+                    in_plane = forward.size();
+                    forward.push_back(-g.plane);
+                } else {
+                    forward.push_back(-g.step - 1);
+                    forward.push_back(-g.step);
+                    forward.push_back(-g.step + 1);
+                    in_plane = forward.size();
+                    for (int dy = -1; dy <= 1; dy++) {
+                        for (int dx = -1; dx <= 1; dx++) {
+                            forward.push_back(-g.plane + dy * g.step + dx);
+                        }
+                    }
+                }
+
+                for (size_t k = 0; k < forward.size(); k++) {
+                    all.push_back(forward[k]);
+                    all.push_back(-forward[k]);
+                }
+            }
+        };
+
+        /**
+         * A value sent to a voxel owned by another slab.
+         */
+        template <typename T>
+        struct Message
+        {
+            int q;
+            T value;
+
+            Message(const int _q, const T _value) : q(_q), value(_value) {}
+        };
+
+        /**
+         * A range of planes that one thread reconstructs. Its
+         * voxels occupy the buffer indices [begin, end).
+         */
+        struct Slab
+        {
+            int z_begin;
+            int z_end;
+            int begin;
+            int end;
+
+            bool contains(const int q) const
+            {
+                return q >= begin && q < end;
+            }
+        };
+
+        template <typename T>
+        Mat padVolume(const vector<Mat>& slices, const VolumeGeometry& g)
+        {
+            Mat volume((g.depth + 2) * (g.rows + 2), g.cols + 2, slices.front().type(), Scalar::all(lowest<T>()));
+            for (int z = 0; z < g.depth; z++) {
+                Mat interior = volume(Rect(1, (z + 1) * (g.rows + 2) + 1, g.cols, g.rows));
+                slices[z].copyTo(interior);
+            }
+            return volume;
+        }
+
+        vector<Mat> cropVolume(const Mat& volume, const VolumeGeometry& g)
+        {
+            vector<Mat> slices(g.depth);
+            for (int z = 0; z < g.depth; z++) {
+                slices[z] = volume(Rect(1, (z + 1) * (g.rows + 2) + 1, g.cols, g.rows));
+            }
+            return slices;
+        }
+
+        vector<Slab> makeSlabs(const VolumeGeometry& g)
+        {
+            const int count = std::max(1, std::min(omp_get_max_threads(), g.depth));
+            vector<Slab> slabs(count);
+            for (int s = 0; s < count; s++) {
+                slabs[s].z_begin = (s * g.depth) / count;
+                slabs[s].z_end = ((s + 1) * g.depth) / count;
+                slabs[s].begin = (slabs[s].z_begin + 1) * g.plane;
+                slabs[s].end = (slabs[s].z_end + 1) * g.plane;
+            }
+            return slabs;
+        }
+
+        /**
+         * Scans in given raster direction over the planes of a
+         * slab, performing one reconstruction step. The first plane
+         * of the scan only looks at neighbors within the plane, as
+         * the adjacent plane belongs to another slab which is being
+         * scanned concurrently.
+         */
+        template <typename T>
+        void rasterReconstruct(const int direction, const T* i, T* j, const VolumeGeometry& g,
+                               const VolumeNeighborhood& n, const Slab& slab)
+        {
+            const int start_z = direction > 0 ? slab.z_begin : slab.z_end - 1;
+            const int stop_z = direction > 0 ? slab.z_end : slab.z_begin - 1;
+            const int start_y = direction > 0 ? 0 : g.rows - 1;
+            const int stop_y = direction > 0 ? g.rows : -1;
+            const int start_x = direction > 0 ? 0 : g.cols - 1;
+
+            for (int z = start_z; z != stop_z; z += direction) {
+                const size_t count = z == start_z ? n.in_plane : n.forward.size();
+
+                for (int y = start_y; y != stop_y; y += direction) {
+                    int p = g.index(start_x, y, z);
+                    for (int x = 0; x < g.cols; x++, p += direction) {
+                        T value = j[p];
+                        for (size_t k = 0; k < count; k++) {
+                            value = std::max(value, j[p + direction * n.forward[k]]);
+                        }
+                        j[p] = std::min(value, i[p]);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Pushes all voxels of a slab that can still raise one
+         * of their neighbors.
+         */
+        template <typename T>
+        void initVoxelQueue(const T* i, const T* j, const VolumeGeometry& g, const VolumeNeighborhood& n,
+                            const Slab& slab, queue<int>& fifo)
+        {
+            for (int z = slab.z_begin; z < slab.z_end; z++) {
+                for (int y = 0; y < g.rows; y++) {
+                    int p = g.index(0, y, z);
+                    for (int x = 0; x < g.cols; x++, p++) {
+                        for (size_t k = 0; k < n.all.size(); k++) {
+                            const int q = p + n.all[k];
+                            if (j[q] < j[p] && j[q] < i[q]) {
+                                fifo.push(p);
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * Propagates values from the queue of a slab. Voxels
+         * of other slabs are not touched; instead, the values
+         * for them are collected in the outbox.
+         */
+        template <typename T>
+        void fifoReconstruct(const T* i, T* j, const VolumeGeometry& g, const VolumeNeighborhood& n,
+                             const Slab& slab, queue<int>& fifo, vector<Message<T> >& outbox)
+        {
+            const int volume_begin = g.plane;
+            const int volume_end = (g.depth + 1) * g.plane;
+
+            while (!fifo.empty()) {
+                const int p = fifo.front();
+                fifo.pop();
+
+                for (size_t k = 0; k < n.all.size(); k++) {
+                    const int q = p + n.all[k];
+                    if (!slab.contains(q)) {
+                        // Sentinel planes never change.
+                        if (q >= volume_begin && q < volume_end) {
+                            outbox.push_back(Message<T>(q, j[p]));
+                        }
+                    } else if (j[q] < j[p] && i[q] != j[q]) {
+                        j[q] = std::min(j[p], i[q]);
+                        fifo.push(q);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Applies the values sent to a slab and queues
+         * all voxels that have been raised.
+         */
+        template <typename T>
+        void receive(const T* i, T* j, const Slab& slab, const vector<Message<T> >& inbox, queue<int>& fifo)
+        {
+            for (typename vector<Message<T> >::const_iterator it = inbox.begin(); it != inbox.end(); it++) {
+                const int q = it->q;
+                if (slab.contains(q) && j[q] < it->value && i[q] != j[q]) {
+                    j[q] = std::min(it->value, i[q]);
+                    fifo.push(q);
+                }
+            }
+        }
+
+        /**
+         * Hybrid reconstruction of a volume. Every slab of planes
+         * is scanned forth and back by its own thread. Then, all
+         * slabs propagate their fifo-queues in parallel, exchanging
+         * the values that cross slab boundaries in rounds until no
+         * queue has work left.
+         *
+         * Exceptions must not leave parallel regions, so control
+         * is checked between the phases and rounds.
+         */
+        template <typename T>
+        vector<Mat> hybrid(const vector<Mat>& marker, const vector<Mat>& mask, const int connectivity,
+                           TaskControl* control)
+        {
+            const VolumeGeometry g(marker.size(), marker.front().rows, marker.front().cols);
+            const VolumeNeighborhood n(connectivity, g);
+            const vector<Slab> slabs = makeSlabs(g);
+            const int count = slabs.size();
+
+            const Mat mask_volume = padVolume<T>(mask, g);
+            Mat marker_volume = padVolume<T>(marker, g);
+            const T* i = mask_volume.ptr<T>();
+            T* j = marker_volume.ptr<T>();
+
+            vector<queue<int> > fifos(count);
+            vector<vector<Message<T> > > outboxes(count);
+
+            checkpoint(control, 0.0);
+#pragma omp parallel for schedule(static, 1)
+            for (int s = 0; s < count; s++) {
+                rasterReconstruct(1, i, j, g, n, slabs[s]);
+                rasterReconstruct(-1, i, j, g, n, slabs[s]);
+            }
+
+#pragma omp parallel for schedule(static, 1)
+            for (int s = 0; s < count; s++) {
+                initVoxelQueue(i, j, g, n, slabs[s], fifos[s]);
+            }
+
+            bool done = false;
+            while (!done) {
+                checkpoint(control, 0.5);
+#pragma omp parallel for schedule(static, 1)
+                for (int s = 0; s < count; s++) {
+                    fifoReconstruct(i, j, g, n, slabs[s], fifos[s], outboxes[s]);
+                }
+
+                // Messages only cross into adjacent slabs.
+#pragma omp parallel for schedule(static, 1)
+                for (int s = 0; s < count; s++) {
+                    if (s > 0) {
+                        receive(i, j, slabs[s], outboxes[s - 1], fifos[s]);
+                    }
+                    if (s < count - 1) {
+                        receive(i, j, slabs[s], outboxes[s + 1], fifos[s]);
+                    }
+                }
+
+                done = true;
+                for (int s = 0; s < count; s++) {
+                    outboxes[s].clear();
+                    done = done && fifos[s].empty();
+                }
+            }
+            return cropVolume(marker_volume, g);
+        }
+    } // namespace
+
+    vector<Mat> hybridReconstruct(const vector<Mat>& marker, const vector<Mat>& mask, const int connectivity,
+                                  TaskControl* control)
+    {
+        CV_Assert(!marker.empty() && marker.size() == mask.size());
+        for (size_t z = 0; z < marker.size(); z++) {
+            CV_Assert(marker[z].type() == marker.front().type() && mask[z].type() == marker.front().type());
+            CV_Assert(marker[z].size == marker.front().size && mask[z].size == marker.front().size);
+        }
+        CV_Assert(marker.front().channels() == 1);
+
+        switch (marker.front().depth()) {
+        case CV_8U:
+            return hybrid<uchar>(marker, mask, connectivity, control);
+        case CV_16U:
+            return hybrid<ushort>(marker, mask, connectivity, control);
+        case CV_32F:
+            return hybrid<float>(marker, mask, connectivity, control);
+        default:
+            CV_Error(CV_StsUnsupportedFormat, "Reconstruction supports CV_8U, CV_16U and CV_32F images only");
+        }
+        return vector<Mat>();
+    }
+
+    vector<Mat> computeHDomes(const vector<Mat>& src, const double h, const int connectivity)
+    {
+        vector<Mat> marker(src.size());
+        for (size_t z = 0; z < src.size(); z++) {
+            marker[z] = src[z] - h;
+        }
+
+        vector<Mat> domes = hybridReconstruct(marker, src, connectivity);
+        for (size_t z = 0; z < src.size(); z++) {
+            domes[z] = src[z] - domes[z];
+        }
+        return domes;
+    }
+
+    vector<Mat> computeHBasins(const vector<Mat>& src, const double h, const int connectivity)
+    {
+        vector<Mat> negatives(src.size());
+        for (size_t z = 0; z < src.size(); z++) {
+            negatives[z] = negative(src[z]);
+        }
+        return computeHDomes(negatives, h, connectivity);
+    }
+}
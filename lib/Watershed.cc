@@ -0,0 +1,237 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2013 Florian Biermann, fbie@itu.dk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <morphology/Watershed.h>
+
+#include <vector>
+
+#include <morphology/HierarchicalQueue.h>
+#include <morphology/Reconstruction.h>
+
+#include "UnionFind.h"
+
+using namespace cv;
+using namespace std;
+
+namespace morphology
+{
+    namespace
+    {
+        const int levels = 256;
+
+        /**
+         * @returns a CV_8U mask of the regional minima of img,
+         * i.e. of its flat zones without a lower neighbor.
+         */
+        Mat regionalMinima(const Mat& img)
+        {
+            const Mat f = img.isContinuous() ? img : img.clone();
+            const uchar* v = f.ptr<uchar>();
+            const int cols = f.cols;
+            const int rows = f.rows;
+            const int dx[] = {-1, 0, 1, -1, 1, -1, 0, 1};
+            const int dy[] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+            // Pixels with a lower neighbor are no minima, nor
+            // is any pixel of their flat zone, so spread the
+            // mark over flat zones.
+            Mat minima(f.size(), CV_8U, Scalar(255));
+            uchar* m = minima.ptr<uchar>();
+            vector<int> stack;
+            for (int p = 0; p < rows * cols; p++) {
+                const int x = p % cols;
+                const int y = p / cols;
+                for (int i = 0; i < 8 && m[p]; i++) {
+                    const int u = x + dx[i];
+                    const int w = y + dy[i];
+                    if (u >= 0 && u < cols && w >= 0 && w < rows && v[w * cols + u] < v[p]) {
+                        m[p] = 0;
+                        stack.push_back(p);
+                    }
+                }
+            }
+
+            while (!stack.empty()) {
+                const int p = stack.back();
+                stack.pop_back();
+                const int x = p % cols;
+                const int y = p / cols;
+                for (int i = 0; i < 8; i++) {
+                    const int u = x + dx[i];
+                    const int w = y + dy[i];
+                    const int q = w * cols + u;
+                    if (u >= 0 && u < cols && w >= 0 && w < rows && m[q] && v[q] == v[p]) {
+                        m[q] = 0;
+                        stack.push_back(q);
+                    }
+                }
+            }
+            return minima;
+        }
+    } // namespace
+
+    Mat labelComponents(const Mat& mask)
+    {
+        CV_Assert(mask.type() == CV_8U);
+
+        const int cols = mask.cols;
+        const int size = mask.rows * cols;
+        vector<int> zpar(size, -1);
+
+        // Unite each pixel with the neighbors processed before
+        // it. Roots stay the first pixel of their component.
+        for (int y = 0; y < mask.rows; y++) {
+            const uchar* m = mask.ptr<uchar>(y);
+            const uchar* above = y > 0 ? mask.ptr<uchar>(y - 1) : 0;
+            for (int x = 0; x < cols; x++) {
+                if (!m[x]) {
+                    continue;
+                }
+
+                const int p = y * cols + x;
+                zpar[p] = p;
+                const int neighbors[] = {x > 0 && m[x - 1] ? p - 1 : -1,
+                                         above && x > 0 && above[x - 1] ? p - cols - 1 : -1,
+                                         above && above[x] ? p - cols : -1,
+                                         above && x + 1 < cols && above[x + 1] ? p - cols + 1 : -1};
+                for (int i = 0; i < 4; i++) {
+                    if (neighbors[i] < 0) {
+                        continue;
+                    }
+                    const int r = findRoot(zpar, neighbors[i]);
+                    const int s = findRoot(zpar, p);
+                    if (r < s) {
+                        zpar[s] = r;
+                    } else if (s < r) {
+                        zpar[r] = s;
+                    }
+                }
+            }
+        }
+
+        Mat labels(mask.size(), CV_32S);
+        vector<int> label(size, 0);
+        int count = 0;
+        for (int y = 0; y < mask.rows; y++) {
+            int* l = labels.ptr<int>(y);
+            for (int x = 0; x < cols; x++) {
+                const int p = y * cols + x;
+                if (zpar[p] < 0) {
+                    l[x] = 0;
+                    continue;
+                }
+
+                const int root = findRoot(zpar, p);
+                if (root == p) {
+                    label[p] = ++count;
+                }
+                l[x] = label[root];
+            }
+        }
+        return labels;
+    }
+
+    Mat watershed(const Mat& img, const Mat& markers, const Mat& mask, TaskControl* control)
+    {
+        CV_Assert(img.type() == CV_8U);
+        CV_Assert(markers.size() == img.size() && (markers.type() == CV_32S || markers.type() == CV_8U));
+        CV_Assert(mask.empty() || (mask.type() == CV_8U && mask.size() == img.size()));
+
+        Mat labels = markers.type() == CV_32S ? markers.clone() : labelComponents(markers);
+
+        // Pixels that may not be flooded are marked as
+        // done with -1 and cleared in the end.
+        const int cols = img.cols;
+        const int rows = img.rows;
+        HierarchicalQueue queue(levels);
+        for (int y = 0; y < rows; y++) {
+            const uchar* f = img.ptr<uchar>(y);
+            const uchar* m = mask.empty() ? 0 : mask.ptr<uchar>(y);
+            int* l = labels.ptr<int>(y);
+            for (int x = 0; x < cols; x++) {
+                if (m && !m[x]) {
+                    l[x] = -1;
+                } else if (l[x] > 0) {
+                    queue.push(f[x], y * cols + x);
+                } else {
+                    l[x] = 0;
+                }
+            }
+        }
+
+        // Flood the image from the markers. A pixel joins the
+        // basin that reaches it first and is served no earlier
+        // than the level of the front, so basins grow in order
+        // of increasing level.
+        const Mat continuous = img.isContinuous() ? img : img.clone();
+        const uchar* f = continuous.ptr<uchar>();
+        int* l = labels.ptr<int>();
+        const int size = rows * cols;
+        const int dx[] = {-1, 0, 1, -1, 1, -1, 0, 1};
+        const int dy[] = {-1, -1, -1, 0, 0, 1, 1, 1};
+        int level = 0;
+        for (int served = 0; !queue.empty(); served++) {
+            if (served % cols == 0) {
+                checkpoint(control, static_cast<double>(served) / size);
+            }
+
+            level = queue.lowest(level);
+            const int p = queue.pop(level);
+            const int x = p % cols;
+            const int y = p / cols;
+            for (int i = 0; i < 8; i++) {
+                const int u = x + dx[i];
+                const int v = y + dy[i];
+                if (u < 0 || u >= cols || v < 0 || v >= rows) {
+                    continue;
+                }
+
+                const int q = v * cols + u;
+                if (l[q] == 0) {
+                    l[q] = l[p];
+                    queue.push(std::max(level, static_cast<int>(f[q])), q);
+                }
+            }
+        }
+
+        for (int p = 0; p < size; p++) {
+            l[p] = std::max(l[p], 0);
+        }
+        checkpoint(control, 1);
+        return labels;
+    }
+
+    Mat watershed(const Mat& img, const double h, const Mat& mask, TaskControl* control)
+    {
+        CV_Assert(img.type() == CV_8U && h >= 1);
+
+        // Adding the h-basins to img fills every basin up to h
+        // above its bottom, which yields the h-minima transform,
+        // the reconstruction by erosion of img + h. Its regional
+        // minima are the h-minima, so minima within one of them
+        // share a marker.
+        const Mat minima = regionalMinima(img + computeHBasins(img, h));
+        return watershed(img, minima, mask, control);
+    }
+}
@@ -22,16 +22,38 @@
  * THE SOFTWARE.
  */
 
+#include <morphology/AlphaTree.h>
+#include <morphology/AttributeFilter.h>
+#include <morphology/Async.h>
+#include <morphology/Batch.h>
+#include <morphology/ComponentTree.h>
 #include <morphology/ConnectedComponent.h>
+#include <morphology/Filters.h>
+#include <morphology/IncrementalFilter.h>
+#include <morphology/MultiAttributeFilter.h>
 #include <morphology/Attributes.h>
+#include <morphology/Profiler.h>
+#include <morphology/Reconstruction.h>
+#include <morphology/SegmentationTools.h>
+#include <morphology/TreeOfShapes.h>
+#include <morphology/Utils.h>
+#include <morphology/Watershed.h>
 
+#include <cstdlib>
 #include <iostream>
+#include <set>
+#include <sstream>
 
 #include <opencv2/core/core.hpp>
 
 using namespace cv;
 using namespace morphology;
 
+bool isEqual(const Mat& a, const Mat& b)
+{
+    return a.size == b.size && a.type() == b.type() && norm(a, b) == 0;
+}
+
 void testSort()
 {
     uchar a_p = 1;
@@ -184,6 +206,943 @@ void testEqualSideLength()
     CV_Assert(b->m_attribute->compute() == 100);
 }
 
+void testLessThan()
+{
+    // Grow a diagonal and a line and compare the integer
+    // predicates with the computed attribute values.
+    uchar p = 0;
+    ConnectedComponentP_t fill = ConnectedComponent::create<FillRatio>(&p, 0, 0, 0);
+    ConnectedComponentP_t side = ConnectedComponent::create<EqualSideLength>(&p, 0, 0, 0);
+    for (int i = 1; i < 5; i++) {
+        ConnectedComponentP_t f = ConnectedComponent::create<FillRatio>(&p, i, i, i);
+        ConnectedComponentP_t s = ConnectedComponent::create<EqualSideLength>(&p, 0, i, i);
+        f->setParent(fill);
+        s->setParent(side);
+
+        for (int lambda = 0; lambda <= 110; lambda++) {
+            CV_Assert(fill->m_attribute->lessThan(lambda) == (fill->m_attribute->compute() < lambda));
+            CV_Assert(side->m_attribute->lessThan(lambda) == (side->m_attribute->compute() < lambda));
+        }
+    }
+
+    // Ratios of exactly 29 / 100, which doubles round down to 28.
+    fill = ConnectedComponent::create<FillRatio>(&p, 0, 0, 0);
+    side = ConnectedComponent::create<EqualSideLength>(&p, 0, 0, 0);
+    for (int i = 1; i < 29; i++) {
+        ConnectedComponentP_t f = ConnectedComponent::create<FillRatio>(&p, i == 28 ? 99 : i, 0, i);
+        ConnectedComponentP_t s = ConnectedComponent::create<EqualSideLength>(&p, 99, i, i);
+        f->setParent(fill);
+        s->setParent(side);
+    }
+    CV_Assert(fill->m_attribute->compute() == 29 && side->m_attribute->compute() == 29);
+    CV_Assert(!fill->m_attribute->lessThan(29) && fill->m_attribute->lessThan(30));
+    CV_Assert(!side->m_attribute->lessThan(29) && side->m_attribute->lessThan(30));
+}
+
+void testTreeRules()
+{
+    // An elongated plateau with a square peak in it.
+    Mat image(9, 13, CV_8U, Scalar(0));
+    image(Rect(2, 3, 9, 3)) = Scalar(100);
+    image(Rect(3, 3, 3, 3)) = Scalar(200);
+
+    const ComponentTree tree = ComponentTree::build<EqualSideLength>(image);
+    CV_Assert(tree.attribute(3 * 13 + 2) == 33);
+    CV_Assert(tree.attribute(3 * 13 + 3) == 100);
+
+    Mat direct(image.size(), CV_8U, Scalar(0));
+    direct(Rect(3, 3, 3, 3)) = Scalar(200);
+    Mat subtractive(image.size(), CV_8U, Scalar(0));
+    subtractive(Rect(3, 3, 3, 3)) = Scalar(100);
+    const Mat removed(image.size(), CV_8U, Scalar(0));
+
+    CV_Assert(isEqual(tree.filter(50, RULE_MIN), removed));
+    CV_Assert(isEqual(tree.filter(50, RULE_MAX), image));
+    CV_Assert(isEqual(tree.filter(50, RULE_DIRECT), direct));
+    CV_Assert(isEqual(tree.filter(50, RULE_SUBTRACTIVE), subtractive));
+    CV_Assert(isEqual(tree.filter(50, RULE_VITERBI), removed));
+    CV_Assert(isEqual(tree.filter(0, RULE_VITERBI), image));
+
+    // The root is kept even if it fails the criterion.
+    Mat square(4, 12, CV_8U, Scalar(0));
+    square(Rect(1, 0, 3, 3)) = Scalar(200);
+    const ComponentTree squares = ComponentTree::build<EqualSideLength>(square);
+    for (int rule = RULE_MIN; rule <= RULE_VITERBI; rule++) {
+        CV_Assert(isEqual(squares.filter(50, static_cast<TreeRule>(rule)), square));
+    }
+
+    // Closings filter the min-tree.
+    const TreeFilter<EqualSideLength> filter(RULE_SUBTRACTIVE);
+    CV_Assert(isEqual(filter.close(negative(image.clone()), 50), negative(subtractive.clone())));
+
+    // For increasing attributes, all rules agree with the
+    // union-find filter.
+    Mat noise(32, 32, CV_8U);
+    RNG rng(7);
+    for (int i = 0; i < noise.rows * noise.cols; i++) {
+        noise.data[i] = static_cast<uchar>(rng.uniform(0, 8) * 32);
+    }
+    const ComponentTree areas = ComponentTree::build<Area>(noise);
+    const Mat expected = AttributeFilter<Area>().open(static_cast<const Mat&>(noise), 20);
+    for (int rule = RULE_MIN; rule <= RULE_VITERBI; rule++) {
+        CV_Assert(isEqual(areas.filter(20, static_cast<TreeRule>(rule)), expected));
+    }
+    CV_Assert(ComponentTree::build<Perimeter>(image).attribute(3 * 13 + 3) == 12);
+}
+
+void testMultiAttributeFilter()
+{
+    // A small square, a large square and a large L-shape.
+    Mat image(20, 32, CV_8U, Scalar(0));
+    image(Rect(1, 1, 2, 2)) = Scalar(200);
+    image(Rect(5, 1, 6, 6)) = Scalar(200);
+    image(Rect(14, 1, 12, 1)) = Scalar(200);
+    image(Rect(14, 2, 1, 11)) = Scalar(200);
+    const Mat src = image;
+
+    Mat expected(image.size(), CV_8U, Scalar(0));
+    expected(Rect(5, 1, 6, 6)) = Scalar(200);
+
+    const MultiAttributeFilter<Area, FillRatio> filter([](int area, int fill) {
+        return area < 20 || fill < 40;
+    });
+    CV_Assert(isEqual(filter.open(src), expected));
+    CV_Assert(isEqual(filter.close(negative(src)), negative(expected.clone())));
+    CV_Assert(isEqual(filter.open(src, RULE_DIRECT), expected));
+    CV_Assert(isEqual(filter.close(negative(src), RULE_DIRECT), negative(expected.clone())));
+
+    // Contour attributes are notified, too.
+    const MultiAttributeFilter<Perimeter> perimeter([](int p) { return p < 20; });
+    CV_Assert(isEqual(perimeter.open(src), AttributeFilter<Perimeter>().open(src, 20)));
+}
+
+void testLambdaMap()
+{
+    // Two equal squares on either side of the image.
+    Mat image(8, 16, CV_8U, Scalar(0));
+    image(Rect(1, 1, 3, 3)) = Scalar(200);
+    image(Rect(11, 1, 3, 3)) = Scalar(200);
+    const Mat src = image;
+
+    Mat lambdas(image.size(), CV_32S, Scalar(5));
+    lambdas(Rect(8, 0, 8, 8)) = Scalar(20);
+
+    Mat expected = image.clone();
+    expected(Rect(11, 1, 3, 3)) = Scalar(0);
+
+    const AttributeFilter<Area> filter;
+    CV_Assert(isEqual(filter.open(src, lambdas), expected));
+    CV_Assert(isEqual(filter.close(negative(src), lambdas), negative(expected)));
+
+    // A constant map equals a global lambda.
+    const Mat constant(image.size(), CV_32S, Scalar(20));
+    CV_Assert(isEqual(filter.open(src, constant), filter.open(src, 20)));
+}
+
+void testResiduals()
+{
+    // A plateau with a peak and a small blob.
+    Mat image(8, 12, CV_8U, Scalar(10));
+    image(Rect(1, 1, 5, 5)) = Scalar(100);
+    image(Rect(2, 2, 2, 2)) = Scalar(200);
+    image(Rect(8, 1, 3, 3)) = Scalar(50);
+    const Mat src = image;
+
+    Mat top_hat(image.size(), CV_8U, Scalar(0));
+    top_hat(Rect(2, 2, 2, 2)) = Scalar(100);
+    top_hat(Rect(8, 1, 3, 3)) = Scalar(40);
+    CV_Assert(isEqual(attributeTopHat<Area>(src, 10), top_hat));
+    CV_Assert(isEqual(attributeBlackTopHat<Area>(negative(src), 10), top_hat));
+
+    Mat band(image.size(), CV_8U, Scalar(0));
+    band(Rect(1, 1, 5, 5)) = Scalar(90);
+    const ComponentTree tree = ComponentTree::build<Area>(src);
+    CV_Assert(isEqual(tree.residual(10, 30), band));
+
+    Mat residual, scales;
+    tree.ultimateOpening(residual, scales);
+    Mat expected = band.clone();
+    expected(Rect(2, 2, 2, 2)) = Scalar(100);
+    expected(Rect(8, 1, 3, 3)) = Scalar(40);
+    CV_Assert(isEqual(residual, expected));
+    CV_Assert(scales.at<int>(2, 2) == 4 && scales.at<int>(1, 1) == 25 && scales.at<int>(1, 8) == 9 && scales.at<int>(0, 0) == 0);
+
+    tree.ultimateOpening(residual, scales, 20);
+    CV_Assert(residual.at<uchar>(2, 2) == 100 && residual.at<uchar>(1, 1) == 0);
+
+    // Closings beyond the background model leave no residual.
+    CV_Assert(isEqual(ultimateAttributeClosing<Area>(src, 1e6), Mat(image.size(), CV_8U, Scalar(0))));
+}
+
+void testProfile()
+{
+    // A bright peak on a dark plateau.
+    Mat image(6, 8, CV_8U, Scalar(100));
+    image(Rect(1, 1, 2, 2)) = Scalar(200);
+    image(Rect(4, 1, 3, 3)) = Scalar(20);
+    const Mat src = image;
+
+    std::vector<int> lambdas;
+    lambdas.push_back(2);
+    lambdas.push_back(5);
+    lambdas.push_back(12);
+
+    Mat profile, differential;
+    morphologicalProfile<Area>(src, lambdas, profile, &differential);
+    CV_Assert(profile.channels() == 7 && differential.channels() == 6);
+
+    std::vector<Mat> channels, differences;
+    split(profile, channels);
+    split(differential, differences);
+
+    const AttributeFilter<Area> filter;
+    for (int k = 0; k < 3; k++) {
+        CV_Assert(isEqual(channels[4 + k], filter.open(src, lambdas[k])));
+        CV_Assert(isEqual(channels[2 - k], filter.close(src, lambdas[k])));
+    }
+    CV_Assert(isEqual(channels[3], src));
+
+    // The profile decreases from channel to channel.
+    for (int c = 0; c < 6; c++) {
+        CV_Assert(isEqual(differences[c], channels[c] - channels[c + 1]));
+    }
+
+    // Bands are profiled one by one and stacked.
+    std::vector<Mat> bands(2, src);
+    bands[1] = negative(src);
+    Mat multiband, multiband_profile, multiband_differential;
+    merge(bands, multiband);
+    morphologicalProfile<Area>(multiband, lambdas, multiband_profile, &multiband_differential);
+    CV_Assert(multiband_profile.channels() == 14 && multiband_differential.channels() == 12);
+
+    std::vector<Mat> band_channels, band_differences;
+    split(multiband_profile, band_channels);
+    split(multiband_differential, band_differences);
+    for (int c = 0; c < 7; c++) {
+        CV_Assert(isEqual(band_channels[c], channels[c]));
+    }
+    for (int c = 0; c < 6; c++) {
+        CV_Assert(isEqual(band_differences[c], differences[c]));
+    }
+    Mat negative_profile;
+    morphologicalProfile<Area>(bands[1], lambdas, negative_profile);
+    std::vector<Mat> negative_channels;
+    split(negative_profile, negative_channels);
+    for (int c = 0; c < 7; c++) {
+        CV_Assert(isEqual(band_channels[7 + c], negative_channels[c]));
+    }
+}
+
+void testTreeOfShapes()
+{
+    // Bright and dark speckle and a bright square with a hole.
+    Mat image(10, 12, CV_8U, Scalar(100));
+    image.at<uchar>(2, 2) = 200;
+    image.at<uchar>(7, 3) = 0;
+    image(Rect(6, 3, 4, 4)) = Scalar(180);
+    image.at<uchar>(4, 7) = 50;
+    const Mat src = image;
+
+    Mat expected(image.size(), CV_8U, Scalar(100));
+    expected(Rect(6, 3, 4, 4)) = Scalar(180);
+
+    CV_Assert(isEqual(selfDualFilter<Area>(src, 3), expected));
+    CV_Assert(isEqual(selfDualFilter<Area>(negative(src), 3), negative(expected)));
+    CV_Assert(isEqual(selfDualFilter<Area>(src, 17), Mat(image.size(), CV_8U, Scalar(100))));
+
+    // Nothing is removed for lambda 1, and the generic
+    // attributes agree with the areas.
+    Mat noise(24, 24, CV_8U);
+    RNG rng(11);
+    for (int i = 0; i < noise.rows * noise.cols; i++) {
+        noise.data[i] = static_cast<uchar>(rng.uniform(0, 16) * 16);
+    }
+    const TreeOfShapes tree(noise);
+    CV_Assert(isEqual(tree.filter(tree.areas(), 1), noise));
+    const std::vector<int> areas = tree.areas();
+    const std::vector<int> attributes = tree.attributes<Area>();
+    for (size_t p = 0; p < areas.size(); p++) {
+        CV_Assert(!tree.isCanonical(p) || areas[p] == attributes[p]);
+    }
+    CV_Assert(tree.areas()[tree.root()] == noise.rows * noise.cols);
+}
+
+void testAlternatingFilter()
+{
+    Mat noise(40, 40, CV_8U);
+    RNG rng(5);
+    for (int i = 0; i < noise.rows * noise.cols; i++) {
+        noise.data[i] = static_cast<uchar>(rng.uniform(0, 8) * 32);
+    }
+    const Mat src = noise;
+
+    std::vector<int> lambdas;
+    lambdas.push_back(2);
+    lambdas.push_back(5);
+    lambdas.push_back(12);
+    lambdas.push_back(30);
+
+    // Equal to the sequence of filters on pixels.
+    Mat open_close = src.clone();
+    Mat close_open = src.clone();
+    for (size_t i = 0; i < lambdas.size(); i++) {
+        areaOpen(open_close, lambdas[i]);
+        areaClose(open_close, lambdas[i]);
+        areaClose(close_open, lambdas[i]);
+        areaOpen(close_open, lambdas[i]);
+    }
+    CV_Assert(isEqual(areaAlternatingFilter(src, lambdas), open_close));
+    CV_Assert(isEqual(areaAlternatingFilter(src, lambdas, false), close_open));
+}
+
+void testIncrementalFilter()
+{
+    Mat frame(96, 128, CV_8U);
+    RNG rng(13);
+    for (int i = 0; i < frame.rows * frame.cols; i++) {
+        frame.data[i] = static_cast<uchar>(rng.uniform(0, 8) * 32);
+    }
+
+    const AttributeFilter<Area> filter;
+    IncrementalAreaFilter opening(6, false, 16);
+    IncrementalAreaFilter closing(6, true, 16);
+    CV_Assert(isEqual(opening.apply(frame), filter.open(static_cast<const Mat&>(frame), 6)));
+    CV_Assert(opening.filteredPixels() == frame.rows * frame.cols);
+    closing.apply(frame);
+
+    // Change a few pixels near the border and in the middle.
+    Mat changed(frame.size(), CV_8U, Scalar(0));
+    for (int i = 0; i < 5; i++) {
+        const int x = i < 3 ? 2 + i : 60 + i;
+        const int y = i < 3 ? 90 : 40;
+        frame.at<uchar>(y, x) = static_cast<uchar>(255 - frame.at<uchar>(y, x));
+        changed.at<uchar>(y, x) = 1;
+    }
+    const Mat src = frame;
+
+    CV_Assert(isEqual(opening.apply(frame), filter.open(src, 6)));
+    CV_Assert(opening.filteredPixels() < frame.rows * frame.cols);
+    CV_Assert(isEqual(closing.apply(frame, changed), filter.close(src, 6)));
+    CV_Assert(closing.filteredPixels() < frame.rows * frame.cols);
+
+    // An unchanged frame is not filtered at all.
+    opening.apply(frame);
+    CV_Assert(opening.filteredPixels() == 0);
+}
+
+void testChannels()
+{
+    Mat image(48, 64, CV_8UC3);
+    RNG rng(17);
+    for (size_t i = 0; i < image.total() * image.channels(); i++) {
+        image.data[i] = static_cast<uchar>(rng.uniform(0, 4) * 64);
+    }
+    const Mat src = image;
+    const Mat marker = src - Scalar::all(64);
+
+    // Marginal filters match filtering each channel.
+    const AttributeFilter<Area> filter;
+    vector<Mat> channels, markers, openings, closings, reconstructions;
+    split(src, channels);
+    split(marker, markers);
+    split(filter.open(src, 5), openings);
+    split(filter.close(src, 5), closings);
+    split(hybridReconstruct(marker, src), reconstructions);
+    for (int c = 0; c < src.channels(); c++) {
+        const Mat channel = channels[c];
+        CV_Assert(isEqual(openings[c], filter.open(channel, 5)));
+        CV_Assert(isEqual(closings[c], filter.close(channel, 5)));
+        CV_Assert(isEqual(reconstructions[c], hybridReconstruct(markers[c], channel)));
+    }
+    CV_Assert(isEqual(parallelReconstruct(marker, src), hybridReconstruct(marker, src)));
+    CV_Assert(isEqual(TreeFilter<Area>().open(src, 5), filter.open(src, 5)));
+
+    // Lexicographic filters only lower colours to colours of the image.
+    Mat palette;
+    const Mat ranks = lexicographicRanks(src, palette);
+    CV_Assert(isEqual(fromLexicographicRanks(ranks, palette), src));
+
+    const TreeFilter<Area> lexicographic(RULE_DIRECT, ORDER_LEXICOGRAPHIC);
+    const Mat opening = lexicographic.open(src, 5);
+    CV_Assert(isEqual(opening, fromLexicographicRanks(TreeFilter<Area>().open(ranks, 5), palette)));
+    for (size_t i = 0; i < src.total(); i++) {
+        const uchar* p = opening.data + 3 * i;
+        const uchar* q = src.data + 3 * i;
+        CV_Assert(!std::lexicographical_compare(q, q + 3, p, p + 3));
+    }
+}
+
+void testAlphaTree()
+{
+    // Two colour regions with a little noise, split by a
+    // bright line, and a small blob in the right region.
+    Mat image(24, 32, CV_8UC3);
+    RNG rng(19);
+    for (int y = 0; y < image.rows; y++) {
+        uchar* p = image.ptr<uchar>(y);
+        for (int x = 0; x < image.cols; x++, p += 3) {
+            const bool left = x < 15;
+            p[0] = static_cast<uchar>((left ? 40 : 200) + rng.uniform(0, 4));
+            p[1] = static_cast<uchar>(100 + rng.uniform(0, 4));
+            p[2] = static_cast<uchar>((left ? 200 : 40) + rng.uniform(0, 4));
+        }
+    }
+    image(Rect(15, 0, 2, image.rows)) = Scalar(255, 255, 255);
+    image(Rect(24, 10, 2, 2)) = Scalar(200, 10, 40);
+
+    const AlphaTree tree(image);
+    const vector<int>& parent = tree.parent();
+    CV_Assert(parent[tree.root()] == tree.root());
+    CV_Assert(tree.areas()[tree.root()] == image.rows * image.cols);
+    for (int n = 0; n < tree.root(); n++) {
+        CV_Assert(parent[n] > n);
+        CV_Assert(n < image.rows * image.cols || tree.alphas()[parent[n]] > tree.alphas()[n]);
+    }
+    CV_Assert(tree.areas() == tree.attributes<Area>());
+
+    // The line and the blob are split off at a low alpha,
+    // the blob is merged back by its area.
+    double regions;
+    minMaxLoc(tree.cut(10), 0, &regions);
+    CV_Assert(regions == 3);
+    const Mat labels = tree.cut(10, 5);
+    minMaxLoc(labels, 0, &regions);
+    CV_Assert(regions == 2);
+    CV_Assert(labels.at<int>(10, 24) == labels.at<int>(0, 31));
+    CV_Assert(labels.at<int>(0, 0) != labels.at<int>(0, 15));
+    CV_Assert(isEqual(alphaSegmentation<Area>(image, 10, 5), labels));
+
+    // All pixels are one region above the largest dissimilarity.
+    minMaxLoc(tree.cut(255), 0, &regions);
+    CV_Assert(regions == 0);
+}
+
+void testWatershed()
+{
+    // Diagonal neighbors are connected.
+    Mat mask(4, 6, CV_8U, Scalar(0));
+    mask.at<uchar>(0, 0) = 1;
+    mask.at<uchar>(1, 1) = 1;
+    mask.at<uchar>(0, 4) = 1;
+    mask.at<uchar>(3, 2) = 1;
+    const Mat components = labelComponents(mask);
+    CV_Assert(components.at<int>(1, 1) == 1 && components.at<int>(0, 4) == 2 && components.at<int>(3, 2) == 3);
+    CV_Assert(components.at<int>(0, 1) == 0);
+
+    // Two touching cells, i.e. the distance to the closer of two
+    // centers, with a shallow minimum in the left one.
+    Mat image(21, 40, CV_8U);
+    Mat cells(image.size(), CV_8U, Scalar(0));
+    for (int y = 0; y < image.rows; y++) {
+        for (int x = 0; x < image.cols; x++) {
+            const double d = std::min(std::sqrt((x - 12.0) * (x - 12.0) + (y - 10.0) * (y - 10.0)),
+                                      std::sqrt((x - 27.0) * (x - 27.0) + (y - 10.0) * (y - 10.0)));
+            image.at<uchar>(y, x) = static_cast<uchar>(std::min(10 * d, 250.0));
+            cells.at<uchar>(y, x) = d < 9 ? 255 : 0;
+        }
+    }
+    image.at<uchar>(10, 5) = 55;
+
+    const Mat labels = watershed(image, 10, cells);
+    double basins;
+    minMaxLoc(labels, 0, &basins);
+    CV_Assert(basins == 2);
+    CV_Assert(labels.at<int>(10, 12) == 1 && labels.at<int>(10, 5) == 1 && labels.at<int>(10, 19) == 1);
+    CV_Assert(labels.at<int>(10, 27) == 2 && labels.at<int>(10, 20) == 2);
+    CV_Assert(labels.at<int>(0, 0) == 0);
+    minMaxLoc(watershed(image, 1, cells), 0, &basins);
+    CV_Assert(basins == 3);
+
+    // Pits within one h-minimum share a basin.
+    Mat plateau(9, 12, CV_8U, Scalar(100));
+    plateau(Rect(2, 2, 8, 5)) = Scalar(12);
+    plateau.at<uchar>(4, 3) = 10;
+    plateau.at<uchar>(4, 8) = 10;
+    minMaxLoc(watershed(plateau, 5), 0, &basins);
+    CV_Assert(basins == 1);
+
+    // User-supplied markers keep their labels.
+    Mat markers(image.size(), CV_32S, Scalar(0));
+    markers.at<int>(10, 12) = 7;
+    markers.at<int>(10, 27) = 3;
+    Mat expected = labels.clone();
+    for (int i = 0; i < expected.rows * expected.cols; i++) {
+        int& l = expected.ptr<int>()[i];
+        l = l == 1 ? 7 : (l == 2 ? 3 : 0);
+    }
+    CV_Assert(isEqual(watershed(image, markers, cells), expected));
+}
+
+void testMoments()
+{
+    // A 3x3 square, a horizontal and a vertical line.
+    Mat image(9, 9, CV_8U, Scalar(0));
+    image(Rect(1, 1, 3, 3)) = Scalar(100);
+    image(Rect(1, 6, 5, 1)) = Scalar(200);
+    image(Rect(7, 1, 1, 5)) = Scalar(150);
+    const Mat src = image;
+
+    Mat square = image.clone();
+    square(Rect(1, 6, 5, 1)) = Scalar(0);
+    square(Rect(7, 1, 1, 5)) = Scalar(0);
+
+    Mat lines = image.clone();
+    lines(Rect(1, 1, 3, 3)) = Scalar(0);
+
+    Mat vertical = lines.clone();
+    vertical(Rect(1, 6, 5, 1)) = Scalar(0);
+
+    // Lines have an elongation of 80 and an eccentricity
+    // of 97, the square has 0 for both.
+    CV_Assert(isEqual(AttributeFilter<Elongation>().open(src, 50), lines));
+    CV_Assert(isEqual(AttributeFilter<Eccentricity>().open(src, 90), lines));
+
+    // The moment of inertia of a square is 105, that of
+    // the lines is 524.
+    CV_Assert(isEqual(AttributeFilter<MomentOfInertia>().open(src, 106), lines));
+    CV_Assert(isEqual(AttributeFilter<MomentOfInertia>().open(src, 105), image));
+
+    // Orientation is 0 for the horizontal line and
+    // 90 for the vertical one.
+    CV_Assert(isEqual(AttributeFilter<Orientation>().open(src, 45), vertical));
+}
+
+void testPerimeter()
+{
+    // A 3x3 square with perimeter 12 and a 1x3 line
+    // with perimeter 8 on a dark background.
+    Mat image(7, 9, CV_8U, Scalar(0));
+    image(Rect(1, 1, 3, 3)) = Scalar(100);
+    image(Rect(6, 1, 1, 3)) = Scalar(200);
+    const Mat src = image;
+
+    const AttributeFilter<Perimeter> perimeter;
+    Mat expected = image.clone();
+    expected(Rect(6, 1, 1, 3)) = Scalar(0);
+    CV_Assert(isEqual(perimeter.open(src, 9), expected));
+    CV_Assert(isEqual(perimeter.open(src, 8), image));
+    expected(Rect(1, 1, 3, 3)) = Scalar(0);
+    CV_Assert(isEqual(perimeter.open(src, 13), expected));
+    CV_Assert(!isEqual(perimeter.open(src, 12), expected));
+
+    // 4 pi 9 / 144 = 0.785 for the square
+    // and 4 pi 3 / 64 = 0.589 for the line.
+    const AttributeFilter<Circularity> circularity;
+    expected = image.clone();
+    expected(Rect(6, 1, 1, 3)) = Scalar(0);
+    CV_Assert(isEqual(circularity.open(src, 60), expected));
+
+    // 144 / 9 = 16 for the square and 64 / 3 = 21 for the line.
+    const AttributeFilter<Compactness> compactness;
+    expected = image.clone();
+    expected(Rect(1, 1, 3, 3)) = Scalar(0);
+    CV_Assert(isEqual(compactness.open(src, 17), expected));
+}
+
+/**
+ * Reconstruction by iterated elementary dilation, with
+ * explicit bounds checks. Slow, but obviously correct.
+ */
+Mat referenceReconstruct(const Mat& marker, const Mat& mask)
+{
+    Mat j = marker.clone();
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        Mat k = j.clone();
+        for (int y = 0; y < j.rows; y++) {
+            for (int x = 0; x < j.cols; x++) {
+                uchar value = j.at<uchar>(y, x);
+                for (int v = std::max(y - 1, 0); v <= std::min(y + 1, j.rows - 1); v++) {
+                    for (int u = std::max(x - 1, 0); u <= std::min(x + 1, j.cols - 1); u++) {
+                        value = std::max(value, j.at<uchar>(v, u));
+                    }
+                }
+                value = std::min(value, mask.at<uchar>(y, x));
+                if (value != k.at<uchar>(y, x)) {
+                    k.at<uchar>(y, x) = value;
+                    changed = true;
+                }
+            }
+        }
+        j = k;
+    }
+    return j;
+}
+
+void testReconstructBorder()
+{
+    // The only seed sits in the corner of the image.
+    Mat mask(4, 5, CV_8U, Scalar(10));
+    Mat marker = Mat::zeros(4, 5, CV_8U);
+    marker.at<uchar>(0, 0) = 7;
+
+    const Mat expected(4, 5, CV_8U, Scalar(7));
+    CV_Assert(isEqual(sequentialReconstruct(marker, mask), expected));
+    CV_Assert(isEqual(queueReconstruct(marker, mask), expected));
+    CV_Assert(isEqual(hybridReconstruct(marker, mask), expected));
+    CV_Assert(isEqual(parallelReconstruct(marker, mask), expected));
+}
+
+void testReconstructGreyscale()
+{
+    std::srand(42);
+    Mat mask(23, 31, CV_8U);
+    Mat marker(23, 31, CV_8U);
+    for (int y = 0; y < mask.rows; y++) {
+        for (int x = 0; x < mask.cols; x++) {
+            mask.at<uchar>(y, x) = std::rand() % 256;
+            marker.at<uchar>(y, x) = std::rand() % 8 == 0 ? mask.at<uchar>(y, x) / 2 : 0;
+        }
+    }
+
+    const Mat expected = referenceReconstruct(marker, mask);
+    CV_Assert(isEqual(sequentialReconstruct(marker, mask), expected));
+    CV_Assert(isEqual(queueReconstruct(marker, mask), expected));
+    CV_Assert(isEqual(hybridReconstruct(marker, mask), expected));
+    CV_Assert(isEqual(parallelReconstruct(marker, mask), expected));
+}
+
+void testReconstructDepths()
+{
+    std::srand(7);
+    Mat mask(19, 27, CV_8U);
+    for (int y = 0; y < mask.rows; y++) {
+        for (int x = 0; x < mask.cols; x++) {
+            mask.at<uchar>(y, x) = std::rand() % 256;
+        }
+    }
+    const Mat marker = mask - 40;
+    const Mat expected = referenceReconstruct(marker, mask);
+
+    // Scale to the full 16-bit range, so that
+    // no value fits into eight bits any more.
+    Mat marker_16u, mask_16u, expected_16u;
+    marker.convertTo(marker_16u, CV_16U, 257);
+    mask.convertTo(mask_16u, CV_16U, 257);
+    expected.convertTo(expected_16u, CV_16U, 257);
+    CV_Assert(isEqual(sequentialReconstruct(marker_16u, mask_16u), expected_16u));
+    CV_Assert(isEqual(queueReconstruct(marker_16u, mask_16u), expected_16u));
+    CV_Assert(isEqual(hybridReconstruct(marker_16u, mask_16u), expected_16u));
+
+    // Shift below zero to check the padding.
+    Mat marker_32f, mask_32f, expected_32f;
+    marker.convertTo(marker_32f, CV_32F, 0.5, -100);
+    mask.convertTo(mask_32f, CV_32F, 0.5, -100);
+    expected.convertTo(expected_32f, CV_32F, 0.5, -100);
+    CV_Assert(isEqual(sequentialReconstruct(marker_32f, mask_32f), expected_32f));
+    CV_Assert(isEqual(queueReconstruct(marker_32f, mask_32f), expected_32f));
+    CV_Assert(isEqual(hybridReconstruct(marker_32f, mask_32f), expected_32f));
+}
+
+void testBatchedHDomes()
+{
+    std::srand(3);
+    Mat src(21, 17, CV_8U);
+    for (int y = 0; y < src.rows; y++) {
+        for (int x = 0; x < src.cols; x++) {
+            // Smooth-ish relief with noise, so
+            // there are domes of many heights.
+            src.at<uchar>(y, x) = (x * y) % 97 + std::rand() % 40;
+        }
+    }
+
+    std::vector<double> h;
+    h.push_back(1);
+    h.push_back(5);
+    h.push_back(20);
+    h.push_back(40);
+    h.push_back(300);
+
+    const std::vector<Mat> domes = computeHDomes(src, h);
+    const std::vector<Mat> basins = computeHBasins(src, h);
+    CV_Assert(domes.size() == h.size() && basins.size() == h.size());
+    for (size_t k = 0; k < h.size(); k++) {
+        CV_Assert(isEqual(domes[k], computeHDomes(src, h[k])));
+        CV_Assert(isEqual(basins[k], computeHBasins(src, h[k])));
+    }
+
+    Mat src_16u;
+    src.convertTo(src_16u, CV_16U, 200);
+    const std::vector<Mat> domes_16u = computeHDomes(src_16u, h);
+    for (size_t k = 0; k < h.size(); k++) {
+        CV_Assert(isEqual(domes_16u[k], computeHDomes(src_16u, h[k])));
+    }
+
+    Mat src_32f;
+    src.convertTo(src_32f, CV_32F, 0.25);
+    const std::vector<Mat> domes_32f = computeHDomes(src_32f, h);
+    for (size_t k = 0; k < h.size(); k++) {
+        CV_Assert(isEqual(domes_32f[k], computeHDomes(src_32f, h[k])));
+    }
+}
+
+/**
+ * Volume reconstruction by iterated elementary dilation.
+ */
+std::vector<Mat> referenceReconstruct(const std::vector<Mat>& marker, const std::vector<Mat>& mask, const int connectivity)
+{
+    const int depth = marker.size();
+    std::vector<Mat> j(depth);
+    for (int z = 0; z < depth; z++) {
+        j[z] = marker[z].clone();
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int z = 0; z < depth; z++) {
+            for (int y = 0; y < mask[z].rows; y++) {
+                for (int x = 0; x < mask[z].cols; x++) {
+                    uchar value = j[z].at<uchar>(y, x);
+                    for (int w = std::max(z - 1, 0); w <= std::min(z + 1, depth - 1); w++) {
+                        for (int v = std::max(y - 1, 0); v <= std::min(y + 1, mask[z].rows - 1); v++) {
+                            for (int u = std::max(x - 1, 0); u <= std::min(x + 1, mask[z].cols - 1); u++) {
+                                const int distance = std::abs(w - z) + std::abs(v - y) + std::abs(u - x);
+                                if (connectivity == 26 || distance <= 1) {
+                                    value = std::max(value, j[w].at<uchar>(v, u));
+                                }
+                            }
+                        }
+                    }
+                    value = std::min(value, mask[z].at<uchar>(y, x));
+                    if (value != j[z].at<uchar>(y, x)) {
+                        j[z].at<uchar>(y, x) = value;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+    return j;
+}
+
+void testReconstructVolume()
+{
+    std::srand(11);
+    std::vector<Mat> mask(9), marker(9);
+    for (size_t z = 0; z < mask.size(); z++) {
+        mask[z].create(13, 11, CV_8U);
+        marker[z] = Mat::zeros(13, 11, CV_8U);
+        for (int y = 0; y < mask[z].rows; y++) {
+            for (int x = 0; x < mask[z].cols; x++) {
+                mask[z].at<uchar>(y, x) = std::rand() % 256;
+            }
+        }
+    }
+    marker[8].at<uchar>(12, 10) = mask[8].at<uchar>(12, 10);
+    marker[0].at<uchar>(0, 0) = mask[0].at<uchar>(0, 0);
+    marker[4].at<uchar>(6, 5) = mask[4].at<uchar>(6, 5) / 2;
+
+    const int connectivities[] = {6, 26};
+    for (int c = 0; c < 2; c++) {
+        const std::vector<Mat> expected = referenceReconstruct(marker, mask, connectivities[c]);
+        const std::vector<Mat> reconstruction = hybridReconstruct(marker, mask, connectivities[c]);
+        for (size_t z = 0; z < mask.size(); z++) {
+            CV_Assert(isEqual(reconstruction[z], expected[z]));
+        }
+    }
+
+    // A single plane with 26-connectivity is
+    // a 2-D image with 8-connectivity.
+    const std::vector<Mat> plane(1, mask[0]);
+    CV_Assert(isEqual(computeHDomes(plane, 30).front(), computeHDomes(mask[0], 30)));
+}
+
+void testNegative()
+{
+    Mat image(3, 4, CV_8U, Scalar(5));
+    negative(image);
+    CV_Assert(isEqual(image, Mat(3, 4, CV_8U, Scalar(250))));
+
+    const Mat deep(3, 4, CV_16U, Scalar(5));
+    CV_Assert(isEqual(negative(deep), Mat(3, 4, CV_16U, Scalar(65530))));
+
+    const Mat real(3, 4, CV_32F, Scalar(0.5));
+    CV_Assert(isEqual(negative(real), Mat(3, 4, CV_32F, Scalar(-0.5))));
+}
+
+void testProfiler()
+{
+    Profiler::reset();
+
+    // Disabled spans are not recorded.
+    Profiler::setEnabled(false);
+    {
+        ScopedSpan span("disabled");
+    }
+    CV_Assert(Profiler::statistics().empty());
+
+    Profiler::setEnabled(true);
+#pragma omp parallel for
+    for (int i = 0; i < 4; i++) {
+        ScopedSpan outer("outer");
+        for (int j = 0; j < 3; j++) {
+            ScopedSpan inner("inner");
+        }
+    }
+    Profiler::setEnabled(false);
+
+    const std::vector<SpanStatistics> stats = Profiler::statistics();
+    CV_Assert(stats.size() == 2);
+    CV_Assert(stats[0].path == "outer" && stats[0].count == 4);
+    CV_Assert(stats[1].path == "outer/inner" && stats[1].count == 12);
+    CV_Assert(stats[1].min <= stats[1].mean && stats[1].mean <= stats[1].p99 && stats[1].p99 <= stats[1].max);
+
+    std::ostringstream trace;
+    Profiler::writeChromeTrace(trace);
+    CV_Assert(trace.str().find("\"traceEvents\"") != std::string::npos);
+    CV_Assert(trace.str().find("e+") == std::string::npos);
+
+    Profiler::reset();
+    CV_Assert(Profiler::statistics().empty());
+}
+
+void testFilterStatistics()
+{
+    // Two bright plateaus of area 2 and 6 on a dark background.
+    Mat image(4, 5, CV_8U, Scalar(0));
+    image(Rect(0, 0, 2, 1)) = Scalar(200);
+    image(Rect(2, 2, 3, 2)) = Scalar(100);
+
+    Mat expected = image.clone();
+    expected(Rect(0, 0, 2, 1)) = Scalar(0);
+
+    FilterStatistics statistics;
+    AttributeFilter<Area> filter;
+    filter.open(image, 3, 0, &statistics);
+    CV_Assert(isEqual(image, expected));
+
+#ifdef MORPHOLOGY_STATISTICS
+    CV_Assert(statistics.unions > 0);
+    CV_Assert(statistics.rejected_merges > 0);
+    CV_Assert(statistics.compute_calls > 0);
+    CV_Assert(statistics.peak_node_memory > 0);
+    CV_Assert(!statistics.path_lengths.empty());
+#else
+    CV_Assert(statistics.unions == 0 && statistics.path_lengths.empty());
+#endif
+}
+
+void testConcurrentFilters()
+{
+    Mat image(32, 32, CV_8U);
+    for (int y = 0; y < image.rows; y++) {
+        for (int x = 0; x < image.cols; x++) {
+            image.at<uchar>(y, x) = static_cast<uchar>((x * 7 + y * 13) % 64 + (x / 8 + y / 8) * 16);
+        }
+    }
+
+    const Mat src = image;
+
+    // One filter object shared by all threads.
+    const AttributeFilter<Area> filter;
+    const AttributePatternSpectrum<Area> spectrum;
+    const Mat expected = filter.open(src, 20);
+    const std::vector<int> expected_spectrum = spectrum.open(src, 20);
+
+    bool equal = true;
+#pragma omp parallel for reduction(&&:equal)
+    for (int i = 0; i < 16; i++) {
+        equal = equal && isEqual(filter.open(src, 20), expected);
+        equal = equal && spectrum.open(src, 20) == expected_spectrum;
+    }
+    CV_Assert(equal);
+}
+
+void testBatch()
+{
+    std::vector<Mat> images;
+    for (int i = 0; i < 10; i++) {
+        Mat image(8, 8, CV_8U, Scalar(0));
+        image(Rect(i % 4, i % 3, 2, 2)) = Scalar(100 + i);
+        image(Rect(4, 4, 4, 4)) = Scalar(50);
+        images.push_back(image);
+    }
+
+    ThreadPool pool(3);
+    const AttributeOpening<Area> opening(5);
+    const std::vector<Mat> results = processBatch(images, opening, pool);
+    CV_Assert(results.size() == images.size());
+    for (size_t i = 0; i < images.size(); i++) {
+        Mat expected = images[i].clone();
+        opening.apply(expected);
+        CV_Assert(isEqual(results[i], expected));
+        CV_Assert(results[i].at<uchar>(i % 3, i % 4) <= 50);
+    }
+
+    // Results in order arrive in order.
+    std::vector<size_t> indices;
+    processBatch(images, opening, [&indices](const size_t index, const Mat&) {
+        indices.push_back(index);
+    }, BATCH_IN_ORDER, pool);
+    CV_Assert(indices.size() == images.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        CV_Assert(indices[i] == i);
+    }
+
+    // Buffers of results passed on are reused.
+    ThreadPool single(1);
+    std::set<const uchar*> buffers;
+    processBatch(images, opening, [&buffers](const size_t, const Mat& result) {
+        buffers.insert(result.data);
+    }, BATCH_IN_ORDER, single);
+    CV_Assert(buffers.size() < images.size());
+
+    // Errors of an operation reach the caller.
+    images[3] = Mat(8, 8, CV_32F, Scalar(0));
+    bool thrown = false;
+    try {
+        processBatch(images, opening, pool);
+    } catch (const cv::Exception&) {
+        thrown = true;
+    }
+    CV_Assert(thrown);
+}
+
+void testAsync()
+{
+    Mat image(16, 16, CV_8U);
+    for (int y = 0; y < image.rows; y++) {
+        for (int x = 0; x < image.cols; x++) {
+            image.at<uchar>(y, x) = static_cast<uchar>((x * 31 + y * 17) % 200);
+        }
+    }
+    const Mat src = image;
+
+    // Progress never decreases.
+    std::vector<double> progress;
+    TaskControl control([&progress](const double p) { progress.push_back(p); });
+    std::future<Mat> closing = closeAsync<Area>(src, 10, &control);
+    CV_Assert(isEqual(closing.get(), AttributeFilter<Area>().close(src, 10)));
+    CV_Assert(!progress.empty());
+    for (size_t i = 1; i < progress.size(); i++) {
+        CV_Assert(progress[i - 1] < progress[i] && progress[i] <= 1);
+    }
+
+    const Mat marker = src - 20;
+    std::future<Mat> reconstruction = hybridReconstructAsync(marker, src);
+    CV_Assert(isEqual(reconstruction.get(), referenceReconstruct(marker, src)));
+
+    // Cancelled operations throw from the future.
+    TaskControl cancelled;
+    cancelled.cancel();
+    std::future<std::vector<int> > spectrum = openSpectrumAsync<Area>(src, 10, -1, &cancelled);
+    std::future<Mat> sequential = sequentialReconstructAsync(marker, src, &cancelled);
+    bool thrown[2] = {false, false};
+    try {
+        spectrum.get();
+    } catch (const OperationCancelled&) {
+        thrown[0] = true;
+    }
+    try {
+        sequential.get();
+    } catch (const OperationCancelled&) {
+        thrown[1] = true;
+    }
+    CV_Assert(thrown[0] && thrown[1]);
+}
+
 #define RUN_TEST(x) \
 do {                \
     std::cout << "Running "#x"..." << std::endl; \
@@ -205,6 +1164,51 @@ int main(int argc, char** argv)
 
     // Test Circularity
     RUN_TEST(testEqualSideLength);
+    RUN_TEST(testLessThan);
+
+    // Test ComponentTree
+    RUN_TEST(testTreeRules);
+    RUN_TEST(testMultiAttributeFilter);
+    RUN_TEST(testLambdaMap);
+    RUN_TEST(testResiduals);
+    RUN_TEST(testProfile);
+
+    // Test TreeOfShapes
+    RUN_TEST(testTreeOfShapes);
+
+    // Test filter sequences
+    RUN_TEST(testAlternatingFilter);
+    RUN_TEST(testIncrementalFilter);
+
+    // Test Channels
+    RUN_TEST(testChannels);
+
+    // Test AlphaTree
+    RUN_TEST(testAlphaTree);
+
+    // Test Watershed
+    RUN_TEST(testWatershed);
+
+    // Test Moments and Perimeter
+    RUN_TEST(testMoments);
+    RUN_TEST(testPerimeter);
+
+    // Test Reconstruction
+    RUN_TEST(testReconstructBorder);
+    RUN_TEST(testReconstructGreyscale);
+    RUN_TEST(testReconstructDepths);
+    RUN_TEST(testBatchedHDomes);
+    RUN_TEST(testReconstructVolume);
+    RUN_TEST(testNegative);
+
+    // Test Profiler
+    RUN_TEST(testProfiler);
+    RUN_TEST(testFilterStatistics);
+
+    // Test concurrency
+    RUN_TEST(testConcurrentFilters);
+    RUN_TEST(testBatch);
+    RUN_TEST(testAsync);
 
     std::cout << "All tests done!" << std::endl;
 }